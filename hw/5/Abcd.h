@@ -1,6 +1,7 @@
 #ifndef ABCD_H
 #define ABCD_H
 
+#include "Memory.h"
 #include <vector>
 #include <set>
 #include <utility>
@@ -26,6 +27,34 @@ public:
         uniques.emplace(target);
     }
 
+    // Adds all the results of another report, e.g. from another fold
+    void merge(const Abcd &other)
+    {
+        preds_targets.insert(preds_targets.end(), other.preds_targets.begin(), other.preds_targets.end());
+        uniques.insert(other.uniques.begin(), other.uniques.end());
+    }
+
+    int size() const
+    {
+        return preds_targets.size();
+    }
+
+    // Bytes used by the stored results
+    size_t memory_usage() const
+    {
+        return sizeof(Abcd) + Memory::heap(preds_targets) + Memory::heap(uniques);
+    }
+
+    // Fraction of all results where the prediction was the target
+    double accuracy() const
+    {
+        int right = 0;
+        for (const std::pair<T, T> &pair : preds_targets)
+            right += pair.first == pair.second;
+
+        return preds_targets.empty() ? 0 : static_cast<double>(right) / preds_targets.size();
+    }
+
     void report(std::string db = "db", std::string rx = "rx")
     {
         std::printf(" %5s | %5s | %5s | %5s | %5s | %5s | %5s | %4s | %4s | %4s | %4s | %4s | %4s | class\n",
@@ -0,0 +1,177 @@
+#ifndef ALLOC_COUNTER_H
+#define ALLOC_COUNTER_H
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <malloc.h>
+#include <mutex>
+#include <new>
+
+/**
+ * Replaces the global operator new/delete with versions that count heap
+ * allocations. Since this defines the global operators, include it from
+ * exactly one .cpp file (a benchmark's main), never from another header.
+ *
+ * Besides the totals, allocations and frees are charged to the stage
+ * running on the allocating thread, so a driver can see what each step
+ * of its work costs:
+ *
+ *     {
+ *         AllocCounter::Stage stage("read");
+ *         tbl.read(path);
+ *     }
+ *     AllocCounter::report();
+ *
+ * Work outside any stage is charged to "other". Live and peak bytes use
+ * malloc_usable_size(), so they include malloc's rounding.
+ */
+class AllocCounter
+{
+public:
+    static std::atomic<size_t> allocs;
+    static std::atomic<size_t> bytes;
+
+    struct Totals
+    {
+        std::atomic<size_t> allocs{0}, frees{0};
+        std::atomic<size_t> bytes{0}, freed{0}; // usable bytes
+    };
+
+    static constexpr int MAX_STAGES = 32;
+    static Totals stages[MAX_STAGES];
+    static const char *names[MAX_STAGES];
+    static int stage_count;
+    static std::mutex lock;
+    static thread_local int current;
+
+    static std::atomic<size_t> live;
+    static std::atomic<size_t> peak;
+
+    static void reset()
+    {
+        allocs = 0;
+        bytes = 0;
+    }
+
+    /**
+     * Charges the calling thread's allocations to a stage until it goes
+     * out of scope. Stages nest; names must outlive the program (use
+     * literals), and stages with the same name are added together.
+     */
+    class Stage
+    {
+        int previous;
+
+    public:
+        explicit Stage(const char *name) : previous(current)
+        {
+            current = find(name);
+        }
+
+        ~Stage()
+        {
+            current = previous;
+        }
+    };
+
+    static int find(const char *name)
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        for (int i = 0; i < stage_count; i++)
+            if (std::strcmp(names[i], name) == 0)
+                return i;
+
+        if (stage_count == MAX_STAGES)
+            return 0;
+
+        names[stage_count] = name;
+        return stage_count++;
+    }
+
+    static void on_alloc(void *ptr)
+    {
+        size_t size = malloc_usable_size(ptr);
+        Totals &t = stages[current];
+        t.allocs.fetch_add(1, std::memory_order_relaxed);
+        t.bytes.fetch_add(size, std::memory_order_relaxed);
+
+        size_t now = live.fetch_add(size, std::memory_order_relaxed) + size;
+        size_t high = peak.load(std::memory_order_relaxed);
+        while (now > high && !peak.compare_exchange_weak(high, now, std::memory_order_relaxed))
+            ;
+    }
+
+    static void on_free(void *ptr)
+    {
+        size_t size = malloc_usable_size(ptr);
+        Totals &t = stages[current];
+        t.frees.fetch_add(1, std::memory_order_relaxed);
+        t.freed.fetch_add(size, std::memory_order_relaxed);
+        live.fetch_sub(size, std::memory_order_relaxed);
+    }
+
+    // Prints every stage's allocations and frees, then the live and peak bytes
+    static void report(std::FILE *out = stdout)
+    {
+        std::fprintf(out, "%-20s %12s %12s %12s %12s %12s\n", "stage", "allocs", "frees", "MB alloc", "MB freed", "MB net");
+        for (int i = 0; i < stage_count; i++)
+        {
+            const Totals &t = stages[i];
+            std::fprintf(out, "%-20s %12zu %12zu %12.3f %12.3f %12.3f\n", names[i], t.allocs.load(), t.frees.load(),
+                         t.bytes / 1e6, t.freed / 1e6, (static_cast<double>(t.bytes) - t.freed) / 1e6);
+        }
+        std::fprintf(out, "live %.3f MB, peak %.3f MB\n", live / 1e6, peak / 1e6);
+    }
+};
+std::atomic<size_t> AllocCounter::allocs{0};
+std::atomic<size_t> AllocCounter::bytes{0};
+AllocCounter::Totals AllocCounter::stages[AllocCounter::MAX_STAGES];
+const char *AllocCounter::names[AllocCounter::MAX_STAGES] = {"other"};
+int AllocCounter::stage_count = 1;
+std::mutex AllocCounter::lock;
+thread_local int AllocCounter::current = 0;
+std::atomic<size_t> AllocCounter::live{0};
+std::atomic<size_t> AllocCounter::peak{0};
+
+void *operator new(size_t size)
+{
+    AllocCounter::allocs.fetch_add(1, std::memory_order_relaxed);
+    AllocCounter::bytes.fetch_add(size, std::memory_order_relaxed);
+
+    void *ptr = std::malloc(size ? size : 1);
+    if (!ptr)
+        throw std::bad_alloc();
+    AllocCounter::on_alloc(ptr);
+    return ptr;
+}
+
+void *operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void *ptr) noexcept
+{
+    if (ptr)
+        AllocCounter::on_free(ptr);
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+    operator delete(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept
+{
+    operator delete(ptr);
+}
+
+void operator delete[](void *ptr, size_t) noexcept
+{
+    operator delete(ptr);
+}
+
+#endif
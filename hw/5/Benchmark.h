@@ -0,0 +1,281 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+/**
+ * The part of Google Benchmark's API that bench_suite.cpp uses. Compile
+ * with -DUSE_GOOGLE_BENCHMARK (and -lbenchmark) to use the real library;
+ * otherwise this self-contained harness runs the same benchmarks.
+ *
+ * The harness grows the iteration count until a run takes at least
+ * --benchmark_min_time seconds (default 0.2), then writes the results as
+ * JSON in Google Benchmark's layout, to stdout or to --benchmark_out=FILE,
+ * so runs from either can be diffed with the same tools. Only benchmarks
+ * whose names contain --benchmark_filter=TEXT are run.
+ */
+#ifdef USE_GOOGLE_BENCHMARK
+#include <benchmark/benchmark.h>
+#else
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace benchmark
+{
+class State
+{
+    typedef std::chrono::steady_clock Clock;
+
+    std::vector<int64_t> args;
+    size_t max_iterations;
+    Clock::time_point start;
+    double elapsed = 0; // seconds
+    bool running = false;
+    int64_t items = 0;
+    int64_t bytes = 0;
+
+public:
+    std::map<std::string, double> counters;
+
+    struct Iterator
+    {
+        State *state;
+        size_t left;
+
+        bool operator!=(const Iterator &)
+        {
+            if (left > 0)
+                return true;
+            state->PauseTiming();
+            return false;
+        }
+
+        void operator++()
+        {
+            --left;
+        }
+
+        int operator*() const
+        {
+            return 0;
+        }
+    };
+
+    State(const std::vector<int64_t> &args, size_t iterations) : args(args), max_iterations(iterations) {}
+
+    Iterator begin()
+    {
+        ResumeTiming();
+        return Iterator{this, max_iterations};
+    }
+
+    Iterator end()
+    {
+        return Iterator{this, 0};
+    }
+
+    int64_t range(size_t i = 0) const
+    {
+        return args[i];
+    }
+
+    size_t iterations() const
+    {
+        return max_iterations;
+    }
+
+    void PauseTiming()
+    {
+        if (running)
+            elapsed += std::chrono::duration<double>(Clock::now() - start).count();
+        running = false;
+    }
+
+    void ResumeTiming()
+    {
+        start = Clock::now();
+        running = true;
+    }
+
+    void SetItemsProcessed(int64_t n)
+    {
+        items = n;
+    }
+
+    void SetBytesProcessed(int64_t n)
+    {
+        bytes = n;
+    }
+
+    double get_elapsed() const
+    {
+        return elapsed;
+    }
+
+    int64_t get_items() const
+    {
+        return items;
+    }
+
+    int64_t get_bytes() const
+    {
+        return bytes;
+    }
+};
+
+class Benchmark
+{
+public:
+    typedef void (*Function)(State &);
+
+    std::string name;
+    Function fn;
+    std::vector<std::vector<int64_t>> arg_lists;
+
+    Benchmark(const std::string &name, Function fn) : name(name), fn(fn) {}
+
+    Benchmark *Arg(int64_t arg)
+    {
+        arg_lists.push_back({arg});
+        return this;
+    }
+};
+
+inline std::vector<std::unique_ptr<Benchmark>> &registry()
+{
+    static std::vector<std::unique_ptr<Benchmark>> benchmarks;
+    return benchmarks;
+}
+
+inline Benchmark *RegisterBenchmark(const char *name, Benchmark::Function fn)
+{
+    registry().emplace_back(new Benchmark(name, fn));
+    return registry().back().get();
+}
+
+// Keeps the compiler from optimizing away a value
+template <class T>
+inline void DoNotOptimize(T const &value)
+{
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+inline void ClobberMemory()
+{
+    asm volatile("" : : : "memory");
+}
+
+inline std::string json_escape(const std::string &text)
+{
+    std::string out;
+    for (char c : text)
+    {
+        if (c == '"' || c == '\\')
+            out += '\\';
+        out += c;
+    }
+    return out;
+}
+
+inline int run_all(int argc, char **argv)
+{
+    std::string out_path, filter;
+    double min_time = 0.2;
+    for (int i = 1; i < argc; i++)
+    {
+        std::string arg = argv[i];
+        if (arg.rfind("--benchmark_out=", 0) == 0)
+            out_path = arg.substr(16);
+        else if (arg.rfind("--benchmark_filter=", 0) == 0)
+            filter = arg.substr(19);
+        else if (arg.rfind("--benchmark_min_time=", 0) == 0)
+            min_time = std::stod(arg.substr(21));
+    }
+
+    std::FILE *out = out_path.empty() ? stdout : std::fopen(out_path.c_str(), "w");
+    if (!out)
+    {
+        std::fprintf(stderr, "Error: can't open %s\n", out_path.c_str());
+        return 1;
+    }
+
+    char date[64];
+    std::time_t now = std::time(nullptr);
+    std::strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", std::localtime(&now));
+    std::fprintf(out, "{\n  \"context\": {\n    \"date\": \"%s\",\n    \"library\": \"fallback\"\n  },\n", date);
+    std::fprintf(out, "  \"benchmarks\": [");
+
+    bool first = true;
+    for (const std::unique_ptr<Benchmark> &bm : registry())
+    {
+        std::vector<std::vector<int64_t>> arg_lists = bm->arg_lists;
+        if (arg_lists.empty())
+            arg_lists.push_back({});
+
+        for (const std::vector<int64_t> &args : arg_lists)
+        {
+            std::string name = bm->name;
+            for (int64_t arg : args)
+                name += "/" + std::to_string(arg);
+            if (name.find(filter) == std::string::npos)
+                continue;
+
+            // Grow the iterations until one run is long enough to trust
+            size_t iterations = 1;
+            State state(args, iterations);
+            while (true)
+            {
+                state = State(args, iterations);
+                bm->fn(state);
+
+                double t = state.get_elapsed();
+                if (t >= min_time || iterations >= 1000000000)
+                    break;
+
+                size_t guess = t > 0 ? static_cast<size_t>(iterations * min_time * 1.4 / t) : iterations * 10;
+                iterations = std::max(iterations + 1, std::min(guess, iterations * 10));
+            }
+
+            double ns = state.get_elapsed() * 1e9 / iterations;
+            std::fprintf(out, "%s\n    {\n      \"name\": \"%s\",\n      \"run_type\": \"iteration\",\n",
+                         first ? "" : ",", json_escape(name).c_str());
+            std::fprintf(out, "      \"iterations\": %zu,\n      \"real_time\": %.6g,\n      \"cpu_time\": %.6g,\n",
+                         iterations, ns, ns);
+            if (state.get_items())
+                std::fprintf(out, "      \"items_per_second\": %.6g,\n", state.get_items() / state.get_elapsed());
+            if (state.get_bytes())
+                std::fprintf(out, "      \"bytes_per_second\": %.6g,\n", state.get_bytes() / state.get_elapsed());
+            for (const std::pair<const std::string, double> &counter : state.counters)
+                std::fprintf(out, "      \"%s\": %.6g,\n", json_escape(counter.first).c_str(), counter.second);
+            std::fprintf(out, "      \"time_unit\": \"ns\"\n    }");
+            std::fflush(out);
+            first = false;
+        }
+    }
+
+    std::fprintf(out, "\n  ]\n}\n");
+    if (out != stdout)
+        std::fclose(out);
+    return 0;
+}
+} // namespace benchmark
+
+#define BENCHMARK_CAT_(a, b) a##b
+#define BENCHMARK_CAT(a, b) BENCHMARK_CAT_(a, b)
+#define BENCHMARK(fn) \
+    static ::benchmark::Benchmark *BENCHMARK_CAT(benchmark_, __LINE__) = ::benchmark::RegisterBenchmark(#fn, fn)
+#define BENCHMARK_MAIN()                            \
+    int main(int argc, char **argv)                 \
+    {                                               \
+        return ::benchmark::run_all(argc, argv);    \
+    }
+
+#endif
+
+#endif
@@ -0,0 +1,138 @@
+#ifndef CLUSTER_H
+#define CLUSTER_H
+
+#include "Tbl.h"
+#include "Distance.h"
+#include "FastMap.h"
+#include "Parallel.h"
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+/**
+ * Some rows of a Tbl, held as row numbers into the parent table rather
+ * than copies, with Num and Sym summaries of just those rows. The
+ * summaries follow the order of the parent's get_nums() and get_syms().
+ */
+class TblView
+{
+    const uint32_t *first = nullptr, *last = nullptr;
+    std::vector<Num> nums;
+    std::vector<Sym<>> syms;
+
+    friend class Cluster;
+
+public:
+    size_t size() const
+    {
+        return last - first;
+    }
+
+    // Row numbers in the parent table
+    const uint32_t *begin() const
+    {
+        return first;
+    }
+
+    const uint32_t *end() const
+    {
+        return last;
+    }
+
+    const std::vector<Num> &get_nums() const
+    {
+        return nums;
+    }
+
+    const std::vector<Sym<>> &get_syms() const
+    {
+        return syms;
+    }
+
+    void print() const
+    {
+        std::cout << "|  n: " << size() << "\n";
+        for (const Num &num : nums)
+            std::cout << "|  |  mu: " << num.get_mean() << " sd: " << num.variety() << "\n";
+        for (const Sym<> &sym : syms)
+            std::cout << "|  |  mode: " << sym.get_mode() << " ent: " << sym.variety() << "\n";
+    }
+};
+
+/**
+ * Recursive bi-clustering of a Tbl's rows. Each split projects the rows
+ * onto the line between two far-apart rows and cuts at the median, until
+ * clusters hold at most sqrt(N) rows. This is exactly the FastMap tree
+ * with that leaf size, so the recursion runs in parallel the same way;
+ * the leaves then become TblViews, summarized in parallel.
+ */
+class Cluster
+{
+    Distance distance;
+    FastMap tree;
+    std::vector<TblView> leaves;
+
+public:
+    /**
+     * @param tbl - The table to cluster; it must outlive the cluster
+     * @param threads - Number of threads; 0 means one per core
+     * @param leaf_size - Most rows per cluster; 0 means sqrt(N)
+     */
+    Cluster(const Tbl &tbl, unsigned threads = 0, size_t leaf_size = 0)
+        : distance(tbl),
+          tree(distance, leaf_size ? leaf_size : std::max<size_t>(std::sqrt(tbl.size()), 1), 128, threads)
+    {
+        const std::vector<uint32_t> &order = tree.get_order();
+        std::vector<std::pair<size_t, size_t>> ranges = tree.get_leaves();
+        std::vector<int> num_cols = tbl.get_nums(), sym_cols = tbl.get_syms();
+
+        leaves.resize(ranges.size());
+        const std::vector<Row> &rows = tbl.get_rows();
+        parallel_for(leaves.size(), threads, [&](size_t begin, size_t end, unsigned) {
+            for (size_t l = begin; l < end; l++)
+            {
+                TblView &leaf = leaves[l];
+                leaf.first = order.data() + ranges[l].first;
+                leaf.last = order.data() + ranges[l].second;
+                leaf.nums.resize(num_cols.size());
+                leaf.syms.resize(sym_cols.size());
+
+                for (const uint32_t *r = leaf.first; r != leaf.last; r++)
+                {
+                    const std::vector<std::string> &cells = rows[*r].get_cells();
+
+                    // Missing cells are left out of the summaries
+                    for (size_t k = 0; k < num_cols.size(); k++)
+                    {
+                        leaf.nums[k].add(rows[*r].get_num(num_cols[k]));
+                    }
+
+                    for (size_t k = 0; k < sym_cols.size(); k++)
+                    {
+                        const std::string &cell = cells[sym_cols[k]];
+                        if (!cell.empty() && cell != "?")
+                            leaf.syms[k].add(cell);
+                    }
+                }
+            }
+        });
+    }
+
+    const std::vector<TblView> &get_leaves() const
+    {
+        return leaves;
+    }
+
+    void print() const
+    {
+        for (size_t l = 0; l < leaves.size(); l++)
+        {
+            std::cout << "leaf " << l + 1 << "\n";
+            leaves[l].print();
+        }
+    }
+};
+
+#endif
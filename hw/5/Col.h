@@ -1,15 +1,15 @@
 #ifndef COL_H
 #define COL_H
 
+#include "Memory.h"
 #include <string>
 
 class Col
 {
 protected:
-    // Number of columns. Used to find column number of new cols
-    static unsigned int count;
-
-    // Column number
+    // Column number within its table, from 1; the table assigns it (see
+    // set_id()), and columns outside a table keep 0. Nothing is shared
+    // between columns, so tables can be built on many threads at once.
     unsigned int col = 0;
     std::string text;
     int n;
@@ -18,24 +18,33 @@ public:
     virtual void operator+=(std::string val) {}
     virtual void operator-=(std::string val) {}
     virtual void print() {}
-    virtual double variety() = 0;
+    virtual double variety() const = 0;
     virtual bool isGreater(Col& other, double epsilon) = 0;
 
-    Col()
+    Col() {}
+
+    Col(std::string t) : text(t) {}
+
+    unsigned int get_id() const
     {
-        col = ++count;
+        return col;
     }
 
-    Col(std::string t) : text(t)
+    void set_id(unsigned int id)
     {
-        col = ++count;
+        col = id;
     }
 
-    int size() 
+    int size() const
     {
         return n;
     }
+
+    // Bytes used by this column, including what it holds on the heap
+    virtual size_t memory_usage() const
+    {
+        return sizeof(Col) + Memory::heap(text);
+    }
 };
-unsigned int Col::count = 0;
 
 #endif
\ No newline at end of file
@@ -0,0 +1,244 @@
+#ifndef COLUMNS_H
+#define COLUMNS_H
+
+#include "Tbl.h"
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <limits>
+#include <map>
+#include <string>
+#include <vector>
+
+/**
+ * A columnar copy of a Tbl: one array of doubles per Num column (NaN when
+ * missing) and one array of symbol ids per Sym column (-1 when missing).
+ * Learners that scan a column at a time work on this instead of the
+ * table's rows of strings.
+ *
+ * Symbol ids come from per-column dictionaries. To encode test data the
+ * same way as training data, build it "like" the training Columns: it then
+ * reuses their dictionaries, and symbols they never saw get id -2.
+ */
+class Columns
+{
+    size_t n = 0;
+    std::vector<bool> numeric;
+    std::vector<std::vector<double>> nums;           // [column][row]; empty for syms
+    std::vector<std::vector<int>> syms;              // [column][row]; empty for nums
+    std::vector<std::map<std::string, int>> ids;     // [column] text -> id
+    std::vector<std::vector<std::string>> symbols;   // [column] id -> text
+    std::vector<int> xs, goals;
+
+    void load(const Tbl &tbl, bool grow)
+    {
+        const std::vector<Row> &rows = tbl.get_rows();
+        n = rows.size();
+
+        for (size_t c = 0; c < numeric.size(); c++)
+        {
+            if (numeric[c])
+                nums[c].resize(n);
+            else
+                syms[c].resize(n);
+        }
+
+        for (size_t i = 0; i < n; i++)
+        {
+            const std::vector<std::string> &cells = rows[i].get_cells();
+            for (size_t c = 0; c < numeric.size(); c++)
+            {
+                const std::string &cell = cells[c];
+                bool missing = cell.empty() || cell == "?";
+
+                if (numeric[c])
+                {
+                    // Parsed once already, by the Tbl
+                    nums[c][i] = rows[i].get_num(c);
+                }
+                else if (missing)
+                    syms[c][i] = -1;
+                else if (grow)
+                {
+                    auto it = ids[c].emplace(cell, symbols[c].size());
+                    if (it.second)
+                        symbols[c].push_back(cell);
+                    syms[c][i] = it.first->second;
+                }
+                else
+                {
+                    auto it = ids[c].find(cell);
+                    syms[c][i] = it == ids[c].end() ? -2 : it->second;
+                }
+            }
+        }
+    }
+
+public:
+    Columns(const Tbl &tbl) : xs(tbl.get_xs()), goals(tbl.get_goals())
+    {
+        // One column per kept header, as the rows have
+        std::vector<int> num_cols = tbl.get_nums();
+        size_t width = tbl.get_headers().size();
+
+        numeric.assign(width, false);
+        for (int c : num_cols)
+            numeric[c] = true;
+
+        nums.resize(width);
+        syms.resize(width);
+        ids.resize(width);
+        symbols.resize(width);
+        load(tbl, true);
+    }
+
+    /**
+     * Encodes tbl with the dictionaries of like; tbl must have the same
+     * header as the table like was built from.
+     */
+    Columns(const Tbl &tbl, const Columns &like)
+        : numeric(like.numeric), ids(like.ids), symbols(like.symbols), xs(like.xs), goals(like.goals)
+    {
+        nums.resize(numeric.size());
+        syms.resize(numeric.size());
+        load(tbl, false);
+    }
+
+    /**
+     * Reads a table written by Generator::write_binary(): "TBLC", the
+     * number of columns (uint32), then per column its kind (uint8: 0 Num,
+     * 1 Sym), a goal flag (uint8), its name and, for Syms, its symbols
+     * (uint32 count, then each as a uint32 length and the text). Rows
+     * follow in groups: a uint64 row count (0 at the end), then each
+     * column's values, doubles (NaN when missing) for Nums and int32 ids
+     * (-1 when missing) for Syms.
+     */
+    Columns(std::FILE *in)
+    {
+        char magic[4];
+        uint32_t width = 0;
+        if (std::fread(magic, 1, 4, in) != 4 || std::string(magic, 4) != "TBLC" ||
+            std::fread(&width, sizeof(width), 1, in) != 1)
+        {
+            std::cerr << "Exception: Not a binary table.\n";
+            return;
+        }
+
+        auto read_text = [&]() {
+            uint32_t len = 0;
+            std::fread(&len, sizeof(len), 1, in);
+            std::string text(len, ' ');
+            std::fread(&text[0], 1, len, in);
+            return text;
+        };
+
+        numeric.resize(width);
+        nums.resize(width);
+        syms.resize(width);
+        ids.resize(width);
+        symbols.resize(width);
+        for (uint32_t c = 0; c < width; c++)
+        {
+            uint8_t kind = 0, goal = 0;
+            std::fread(&kind, 1, 1, in);
+            std::fread(&goal, 1, 1, in);
+            read_text();
+
+            numeric[c] = kind == 0;
+            (goal ? goals : xs).push_back(c);
+            if (kind == 1)
+            {
+                uint32_t count = 0;
+                std::fread(&count, sizeof(count), 1, in);
+                for (uint32_t id = 0; id < count; id++)
+                {
+                    symbols[c].push_back(read_text());
+                    ids[c][symbols[c].back()] = id;
+                }
+            }
+        }
+
+        uint64_t m = 0;
+        while (std::fread(&m, sizeof(m), 1, in) == 1 && m > 0)
+        {
+            bool whole = true;
+            for (uint32_t c = 0; c < width && whole; c++)
+            {
+                if (numeric[c])
+                {
+                    nums[c].resize(n + m);
+                    whole = std::fread(&nums[c][n], sizeof(double), m, in) == m;
+                }
+                else
+                {
+                    syms[c].resize(n + m);
+                    whole = std::fread(&syms[c][n], sizeof(int), m, in) == m;
+                }
+            }
+
+            // A short group is dropped, so every column keeps n rows
+            if (!whole)
+            {
+                std::cerr << "Exception: Binary table is truncated, keeping its first " << n << " rows.\n";
+                for (uint32_t c = 0; c < width; c++)
+                {
+                    nums[c].resize(numeric[c] ? n : 0);
+                    syms[c].resize(numeric[c] ? 0 : n);
+                }
+                break;
+            }
+            n += m;
+        }
+    }
+
+    // Number of rows
+    size_t size() const
+    {
+        return n;
+    }
+
+    // Number of columns
+    size_t width() const
+    {
+        return numeric.size();
+    }
+
+    bool is_num(int c) const
+    {
+        return numeric[c];
+    }
+
+    const std::vector<double> &num(int c) const
+    {
+        return nums[c];
+    }
+
+    const std::vector<int> &sym(int c) const
+    {
+        return syms[c];
+    }
+
+    // Number of distinct symbols seen in column c
+    size_t symbol_count(int c) const
+    {
+        return symbols[c].size();
+    }
+
+    // Text of symbol id in column c
+    const std::string &symbol(int c, int id) const
+    {
+        return symbols[c][id];
+    }
+
+    const std::vector<int> &get_xs() const
+    {
+        return xs;
+    }
+
+    const std::vector<int> &get_goals() const
+    {
+        return goals;
+    }
+};
+
+#endif
@@ -0,0 +1,132 @@
+#ifndef CROSS_VAL_H
+#define CROSS_VAL_H
+
+#include "Tbl.h"
+#include "Abcd.h"
+#include "Learner.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+ * M×N cross-validation over a Tbl: M times, shuffle the rows and cut them
+ * into N folds, then for every fold train a fresh learner on the other
+ * folds and test it on this one.
+ *
+ * A fold is just a range of a shuffled array of row numbers, so no rows
+ * are copied, and learners take the table's rows as they are, so nothing
+ * is parsed again. The M×N folds are independent and run on a pool of
+ * threads, each with its own learner and its own Abcd.
+ */
+class CrossVal
+{
+public:
+    // Makes a fresh, untrained learner
+    typedef std::function<std::unique_ptr<Learner>()> Factory;
+
+    struct Fold
+    {
+        int repeat, fold;
+        double ms; // wall time to train and test
+        Abcd<std::string> abcd;
+    };
+
+private:
+    const std::vector<Row> &rows;
+    std::string header;
+    int target;
+    int m, n;
+    unsigned threads;
+    unsigned seed;
+
+    static std::string join(const std::vector<std::string> &cells)
+    {
+        std::string line;
+        for (size_t i = 0; i < cells.size(); i++)
+            line += (i ? "," : "") + cells[i];
+        return line;
+    }
+
+    Fold run(const Factory &make, int repeat, int fold) const
+    {
+        auto start = std::chrono::steady_clock::now();
+
+        // Every repeat shuffles the same way for every learner
+        std::vector<uint32_t> order(rows.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::shuffle(order.begin(), order.end(), std::mt19937(seed + repeat));
+
+        size_t low = order.size() * fold / n, high = order.size() * (fold + 1) / n;
+
+        std::unique_ptr<Learner> learner = make();
+        learner->add_header(header);
+        for (size_t i = 0; i < order.size(); i++)
+            if (i < low || i >= high)
+                learner->add_row(rows[order[i]]);
+
+        Fold result;
+        result.repeat = repeat;
+        result.fold = fold;
+        for (size_t i = low; i < high; i++)
+        {
+            const Row &row = rows[order[i]];
+            result.abcd.add(row.get_cells()[target], learner->classify(row));
+        }
+
+        auto stop = std::chrono::steady_clock::now();
+        result.ms = std::chrono::duration<double, std::milli>(stop - start).count();
+        return result;
+    }
+
+public:
+    /**
+     * @param tbl - The data, which must outlive this; its class is the last goal
+     * @param m - Number of repeats
+     * @param n - Number of folds
+     * @param threads - Number of threads; 0 means one per core
+     * @param seed - Seed for the shuffles
+     */
+    CrossVal(const Tbl &tbl, int m = 5, int n = 5, unsigned threads = 0, unsigned seed = 1)
+        : rows(tbl.get_rows()), header(join(tbl.get_headers())), m(m), n(n), threads(threads), seed(seed)
+    {
+        std::vector<int> goals = tbl.get_goals();
+        if (goals.size() == 0)
+            throw "Error: No goals\n";
+
+        target = goals[goals.size() - 1];
+    }
+
+    /**
+     * Runs all M×N folds with learners from make, which is called once per
+     * fold and may be called from any thread.
+     *
+     * @return One result per fold, in repeat then fold order
+     */
+    std::vector<Fold> run(const Factory &make) const
+    {
+        std::vector<Fold> folds(m * n);
+        parallel_for(folds.size(), threads, [&](size_t begin, size_t end, unsigned) {
+            for (size_t k = begin; k < end; k++)
+                folds[k] = run(make, k / n, k % n);
+        });
+        return folds;
+    }
+
+    // All the folds' results in one report
+    static Abcd<std::string> merge(const std::vector<Fold> &folds)
+    {
+        Abcd<std::string> all;
+        for (const Fold &fold : folds)
+            all.merge(fold.abcd);
+        return all;
+    }
+};
+
+#endif
@@ -0,0 +1,152 @@
+#ifndef CUT_POINTS_H
+#define CUT_POINTS_H
+
+#include "Memory.h"
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <cstddef>
+#include <iostream>
+
+/**
+ * A learned discretization of one column, stored as a sorted list of
+ * boundaries. A value v falls in bin i when cuts[i - 1] <= v < cuts[i],
+ * so k cuts give k + 1 bins. Missing values (NaN) get bin -1.
+ *
+ * The batch bin() is written so that the compiler can vectorize it
+ * (compile with -O3 -march=native): for a handful of cuts every value is
+ * compared against every cut, and for more cuts we run a branchless binary
+ * search with a fixed number of steps over blocks of values.
+ */
+class CutPoints
+{
+    std::vector<double> cuts;
+
+    // The cuts padded with +inf up to a power of two, so the
+    // binary search always takes log2(padded.size()) steps.
+    std::vector<double> padded;
+
+    // Below this many cuts, a linear compare-and-count beats the search.
+    static constexpr size_t LINEAR_MAX = 16;
+    static constexpr size_t BLOCK = 256;
+
+    void pad()
+    {
+        size_t size = 1;
+        while (size < cuts.size() + 1)
+            size *= 2;
+
+        padded = cuts;
+        padded.resize(size, std::numeric_limits<double>::infinity());
+    }
+
+    int search(double val) const
+    {
+        size_t pos = 0;
+        for (size_t step = padded.size() / 2; step >= 1; step /= 2)
+            pos += (padded[pos + step - 1] <= val) ? step : 0;
+
+        // +inf passes the padding too; it belongs in the last bin
+        return static_cast<int>(std::min(pos, cuts.size()));
+    }
+
+public:
+    CutPoints() : padded(1, std::numeric_limits<double>::infinity()) {}
+
+    /**
+     * @param c - The boundaries, in ascending order
+     */
+    CutPoints(std::vector<double> c) : cuts(c)
+    {
+        pad();
+    }
+
+    const std::vector<double> &get_cuts() const
+    {
+        return cuts;
+    }
+
+    size_t memory_usage() const
+    {
+        return sizeof(CutPoints) + Memory::heap(cuts) + Memory::heap(padded);
+    }
+
+    // Number of bins, which is one more than the number of cuts.
+    size_t bins() const
+    {
+        return cuts.size() + 1;
+    }
+
+    // Returns the bin of a single value
+    int bin(double val) const
+    {
+        if (val != val)
+            return -1;
+
+        return search(val);
+    }
+
+    /**
+     * Assigns bins to a whole column of values.
+     *
+     * @param vals - The values to discretize
+     * @param n - Number of values
+     * @param out - Output bins; must have room for n ints
+     */
+    void bin(const double *vals, size_t n, int *out) const
+    {
+        if (cuts.size() <= LINEAR_MAX)
+        {
+            for (size_t i = 0; i < n; i++)
+                out[i] = 0;
+
+            // Cut-major order keeps the inner loop a plain compare-and-add
+            // over contiguous values.
+            for (double cut : cuts)
+                for (size_t i = 0; i < n; i++)
+                    out[i] += vals[i] >= cut;
+        }
+        else
+        {
+            const double *base = padded.data();
+            size_t pos[BLOCK];
+
+            for (size_t start = 0; start < n; start += BLOCK)
+            {
+                size_t len = std::min(BLOCK, n - start);
+                const double *v = vals + start;
+
+                for (size_t i = 0; i < len; i++)
+                    pos[i] = 0;
+
+                for (size_t step = padded.size() / 2; step >= 1; step /= 2)
+                    for (size_t i = 0; i < len; i++)
+                        pos[i] += (base[pos[i] + step - 1] <= v[i]) ? step : 0;
+
+                for (size_t i = 0; i < len; i++)
+                    out[start + i] = static_cast<int>(std::min(pos[i], cuts.size()));
+            }
+        }
+
+        // NaN compares false against every cut; mark it missing.
+        for (size_t i = 0; i < n; i++)
+            out[i] = (vals[i] == vals[i]) ? out[i] : -1;
+    }
+
+    std::vector<int> bin(const std::vector<double> &vals) const
+    {
+        std::vector<int> out(vals.size());
+        bin(vals.data(), vals.size(), out.data());
+        return out;
+    }
+
+    void print() const
+    {
+        std::cout << "cuts: [";
+        for (size_t i = 0; i < cuts.size(); i++)
+            std::cout << (i ? ", " : "") << cuts[i];
+        std::cout << "]\n";
+    }
+};
+
+#endif
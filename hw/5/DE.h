@@ -0,0 +1,182 @@
+#ifndef DE_H
+#define DE_H
+
+#include "Parallel.h"
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <map>
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+ * Differential evolution (Storn and Price, rand/1/bin), for tuning a
+ * learner's settings. Each generation makes one mutant per member of the
+ * population from three others, and the mutant replaces its parent if it
+ * scores at least as well.
+ *
+ * Scoring a candidate usually means a cross-validation, so each generation
+ * scores all its new candidates at once, in parallel, and remembers every
+ * score: candidates are snapped to a grid (integers for integer settings,
+ * 1/1000 of the range otherwise) and repeats are looked up instead.
+ */
+class DE
+{
+public:
+    struct Setting
+    {
+        std::string name;
+        double low, high;
+        bool integer = false;
+    };
+
+    // Scores a candidate; higher is better. Called from several threads.
+    typedef std::function<double(const std::vector<double> &)> Objective;
+
+private:
+    std::vector<Setting> settings;
+    std::map<std::vector<double>, double> cache;
+    size_t evaluations = 0, hits = 0;
+
+    int np, generations;
+    double f, cr;
+    unsigned threads;
+    std::mt19937 rng;
+
+    // Clamps a candidate into range and onto the grid
+    std::vector<double> snap(std::vector<double> x) const
+    {
+        for (size_t i = 0; i < settings.size(); i++)
+        {
+            const Setting &s = settings[i];
+            double val = std::min(std::max(x[i], s.low), s.high);
+            double grid = s.integer ? 1 : (s.high - s.low) / 1000;
+            x[i] = grid > 0 ? s.low + std::round((val - s.low) / grid) * grid : val;
+        }
+        return x;
+    }
+
+    // Scores candidates, in parallel for the ones not seen before
+    std::vector<double> score(const std::vector<std::vector<double>> &xs, const Objective &objective)
+    {
+        std::vector<std::vector<double>> todo;
+        for (const std::vector<double> &x : xs)
+        {
+            if (cache.count(x))
+                hits++;
+            else if (std::find(todo.begin(), todo.end(), x) == todo.end())
+                todo.push_back(x);
+        }
+
+        std::vector<double> scores(todo.size());
+        parallel_for(todo.size(), threads, [&](size_t begin, size_t end, unsigned) {
+            for (size_t i = begin; i < end; i++)
+                scores[i] = objective(todo[i]);
+        });
+
+        evaluations += todo.size();
+        for (size_t i = 0; i < todo.size(); i++)
+            cache[todo[i]] = scores[i];
+
+        std::vector<double> out;
+        for (const std::vector<double> &x : xs)
+            out.push_back(cache[x]);
+        return out;
+    }
+
+public:
+    /**
+     * @param settings - What to tune, and their ranges
+     * @param np - Population size, at least 4; 0 means 10 per setting
+     * @param generations - Number of generations
+     * @param f - Mutation factor
+     * @param cr - Crossover rate
+     * @param threads - Number of threads; 0 means one per core
+     * @param seed - Seed for the population and the mutations
+     */
+    DE(const std::vector<Setting> &settings, int np = 0, int generations = 10, double f = 0.75,
+       double cr = 0.3, unsigned threads = 0, unsigned seed = 1)
+        : settings(settings), np(std::max<int>(np ? np : 10 * settings.size(), 4)), generations(generations),
+          f(f), cr(cr), threads(threads), rng(seed)
+    {
+    }
+
+    /**
+     * Runs the search.
+     *
+     * @param objective - Scores a candidate, given in the order of the settings
+     * @param start - A candidate to seed the population with, e.g. the defaults
+     * @return The best candidate found
+     */
+    std::vector<double> run(const Objective &objective, const std::vector<double> &start = {})
+    {
+        size_t d = settings.size();
+        std::uniform_real_distribution<double> unit(0, 1);
+
+        std::vector<std::vector<double>> pop;
+        for (int i = 0; i < np; i++)
+        {
+            std::vector<double> x(d);
+            for (size_t j = 0; j < d; j++)
+                x[j] = settings[j].low + unit(rng) * (settings[j].high - settings[j].low);
+            pop.push_back(snap(i == 0 && start.size() == d ? start : x));
+        }
+
+        std::vector<double> scores = score(pop, objective);
+
+        for (int g = 0; g < generations; g++)
+        {
+            std::vector<std::vector<double>> mutants;
+            for (int i = 0; i < np; i++)
+            {
+                // Three distinct others
+                int a, b, c;
+                do a = rng() % np; while (a == i);
+                do b = rng() % np; while (b == i || b == a);
+                do c = rng() % np; while (c == i || c == a || c == b);
+
+                std::vector<double> y = pop[i];
+                size_t forced = rng() % d; // at least one setting changes
+                for (size_t j = 0; j < d; j++)
+                    if (j == forced || unit(rng) < cr)
+                        y[j] = pop[a][j] + f * (pop[b][j] - pop[c][j]);
+
+                mutants.push_back(snap(y));
+            }
+
+            std::vector<double> mutant_scores = score(mutants, objective);
+            for (int i = 0; i < np; i++)
+            {
+                if (mutant_scores[i] >= scores[i])
+                {
+                    pop[i] = mutants[i];
+                    scores[i] = mutant_scores[i];
+                }
+            }
+        }
+
+        return pop[std::max_element(scores.begin(), scores.end()) - scores.begin()];
+    }
+
+    // Score of a candidate seen during run()
+    double get_score(const std::vector<double> &x) const
+    {
+        auto it = cache.find(snap(x));
+        return it == cache.end() ? std::nan("") : it->second;
+    }
+
+    // Number of times the objective was called
+    size_t get_evaluations() const
+    {
+        return evaluations;
+    }
+
+    // Number of candidates whose score was remembered
+    size_t get_hits() const
+    {
+        return hits;
+    }
+};
+
+#endif
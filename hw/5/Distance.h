@@ -0,0 +1,270 @@
+#ifndef DISTANCE_H
+#define DISTANCE_H
+
+#include "Tbl.h"
+#include "Parallel.h"
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <limits>
+#include <map>
+#include <string>
+#include <vector>
+
+/**
+ * Normalized Minkowski distances between the rows of a Tbl, over its xs
+ * columns. Num cells are scaled to [0, 1] by the column's low and high;
+ * Sym cells differ by 0 (same symbol) or 1. Missing cells follow Aha's
+ * rule: if both are missing the difference is 1, and if one is missing
+ * the other is assumed to be as far away as it can be. The total is
+ * divided by the number of columns, so distances are in [0, 1].
+ *
+ * The table is copied column by column (doubles for Nums, symbol ids for
+ * Syms), so that a query-vs-all scan runs down contiguous arrays.
+ */
+class Distance
+{
+public:
+    // A row in normalized form; also used for rows from outside the table
+    struct Point
+    {
+        std::vector<double> nums; // NaN if missing
+        std::vector<int> syms;    // -1 if missing, -2 if never seen
+    };
+
+private:
+    std::vector<int> num_cols, sym_cols; // Tbl column of each num/sym
+    std::vector<double> lows, ranges;
+    std::vector<std::vector<double>> nums;           // [num][row]
+    std::vector<std::vector<int>> syms;              // [sym][row]
+    std::vector<std::map<std::string, int>> symbols; // [sym] text -> id
+    size_t n = 0;
+    double p;
+
+    static constexpr size_t BLOCK = 1024;
+
+    double normalize(size_t k, double val) const
+    {
+        if (val != val)
+            return val;
+
+        return ranges[k] > 0 ? (val - lows[k]) / ranges[k] : 0;
+    }
+
+    double power(double d) const
+    {
+        return p == 1 ? d : (p == 2 ? d * d : std::pow(d, p));
+    }
+
+    // Adds the distance terms of rows at(0), ..., at(len - 1) to out
+    template <class Index>
+    void accumulate(const Point &q, Index at, size_t len, double *out) const
+    {
+        for (size_t k = 0; k < nums.size(); k++)
+        {
+            const double *col = nums[k].data();
+            double a = q.nums[k];
+
+            if (a != a)
+            {
+                // Query missing: assume the far end from each row's value
+                for (size_t i = 0; i < len; i++)
+                {
+                    double b = col[at(i)];
+                    double d = b != b ? 1 : std::max(b, 1 - b);
+                    out[i] += power(d);
+                }
+            }
+            else
+            {
+                double far = std::max(a, 1 - a);
+                for (size_t i = 0; i < len; i++)
+                {
+                    double b = col[at(i)];
+                    double d = b != b ? far : std::abs(a - b);
+                    out[i] += power(d);
+                }
+            }
+        }
+
+        for (size_t k = 0; k < syms.size(); k++)
+        {
+            const int *col = syms[k].data();
+            int a = q.syms[k];
+
+            for (size_t i = 0; i < len; i++)
+                out[i] += (a < 0 || col[at(i)] != a) ? 1.0 : 0.0;
+        }
+    }
+
+    double finish(double sum) const
+    {
+        double avg = sum / std::max<size_t>(nums.size() + syms.size(), 1);
+        return p == 1 ? avg : (p == 2 ? std::sqrt(avg) : std::pow(avg, 1 / p));
+    }
+
+public:
+    /**
+     * @param tbl - The table; its rows are copied, so it may change later
+     * @param p - The Minkowski exponent: 1 for Manhattan, 2 for Euclidean
+     */
+    Distance(const Tbl &tbl, double p = 2) : p(p)
+    {
+        std::vector<int> num_list = tbl.get_nums();
+        for (int c : tbl.get_xs())
+        {
+            if (std::find(num_list.begin(), num_list.end(), c) != num_list.end())
+            {
+                const Num &num = dynamic_cast<const Num &>(tbl.get_col(c));
+                num_cols.push_back(c);
+                lows.push_back(num.get_low());
+                ranges.push_back(num.get_high() - num.get_low());
+            }
+            else
+                sym_cols.push_back(c);
+        }
+
+        const std::vector<Row> &rows = tbl.get_rows();
+        n = rows.size();
+        nums.assign(num_cols.size(), std::vector<double>(n));
+        syms.assign(sym_cols.size(), std::vector<int>(n));
+        symbols.resize(sym_cols.size());
+
+        for (size_t i = 0; i < n; i++)
+        {
+            const std::vector<std::string> &cells = rows[i].get_cells();
+
+            for (size_t k = 0; k < num_cols.size(); k++)
+                nums[k][i] = normalize(k, rows[i].get_num(num_cols[k]));
+
+            for (size_t k = 0; k < sym_cols.size(); k++)
+            {
+                const std::string &cell = cells[sym_cols[k]];
+                if (cell.empty() || cell == "?")
+                    syms[k][i] = -1;
+                else
+                    syms[k][i] = symbols[k].emplace(cell, symbols[k].size()).first->second;
+            }
+        }
+    }
+
+    // Number of rows
+    size_t size() const
+    {
+        return n;
+    }
+
+    // Returns row i in normalized form
+    Point point(size_t i) const
+    {
+        Point q;
+        for (const std::vector<double> &col : nums)
+            q.nums.push_back(col[i]);
+        for (const std::vector<int> &col : syms)
+            q.syms.push_back(col[i]);
+        return q;
+    }
+
+    /**
+     * Normalizes a row from outside the table, made by the table's own
+     * parse() so its Num cells are already parsed.
+     */
+    Point point(const Row &row) const
+    {
+        const std::vector<std::string> &cells = row.get_cells();
+        Point q;
+        for (size_t k = 0; k < num_cols.size(); k++)
+            q.nums.push_back(normalize(k, row.get_num(num_cols[k])));
+
+        for (size_t k = 0; k < sym_cols.size(); k++)
+        {
+            const std::string &cell = cells[sym_cols[k]];
+            auto it = symbols[k].find(cell);
+            if (cell.empty() || cell == "?")
+                q.syms.push_back(-1);
+            else
+                q.syms.push_back(it == symbols[k].end() ? -2 : it->second);
+        }
+        return q;
+    }
+
+    // Distance between a point and row i
+    double dist(const Point &q, size_t i) const
+    {
+        double sum = 0;
+        accumulate(q, [i](size_t) { return i; }, 1, &sum);
+        return finish(sum);
+    }
+
+    // Distance between rows i and j
+    double dist(size_t i, size_t j) const
+    {
+        return dist(point(i), j);
+    }
+
+    /**
+     * Distances from a point to every row.
+     *
+     * @param out - Output distances; must have room for size() doubles
+     */
+    void dists(const Point &q, double *out) const
+    {
+        // Work a block of rows at a time, so the sums stay in cache while
+        // every column passes over them
+        for (size_t start = 0; start < n; start += BLOCK)
+        {
+            size_t len = std::min(BLOCK, n - start);
+            std::fill(out + start, out + start + len, 0.0);
+            accumulate(q, [start](size_t i) { return start + i; }, len, out + start);
+
+            for (size_t i = start; i < start + len; i++)
+                out[i] = finish(out[i]);
+        }
+    }
+
+    std::vector<double> dists(const Point &q) const
+    {
+        std::vector<double> out(n);
+        dists(q, out.data());
+        return out;
+    }
+
+    /**
+     * Distances from a point to a subset of rows.
+     *
+     * @param rows - The row numbers
+     * @param m - Number of rows
+     * @param out - Output distances; must have room for m doubles
+     */
+    void dists(const Point &q, const uint32_t *rows, size_t m, double *out) const
+    {
+        for (size_t start = 0; start < m; start += BLOCK)
+        {
+            size_t len = std::min(BLOCK, m - start);
+            const uint32_t *block = rows + start;
+            std::fill(out + start, out + start + len, 0.0);
+            accumulate(q, [block](size_t i) { return block[i]; }, len, out + start);
+
+            for (size_t i = start; i < start + len; i++)
+                out[i] = finish(out[i]);
+        }
+    }
+
+    /**
+     * Distances between every pair of rows, as a row-major n x n matrix.
+     * Rows of the matrix are split across threads.
+     *
+     * @param threads - Number of threads; 0 means one per core
+     */
+    std::vector<double> all_pairs(unsigned threads = 0) const
+    {
+        std::vector<double> out(n * n);
+        parallel_for(n, threads, [&](size_t begin, size_t end, unsigned) {
+            for (size_t i = begin; i < end; i++)
+                dists(point(i), &out[i * n]);
+        });
+        return out;
+    }
+};
+
+#endif
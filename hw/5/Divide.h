@@ -7,108 +7,95 @@
 #include <utility>
 #include <cmath>
 #include <string>
+#include <type_traits>
 #include "Num.h"
+#include "CutPoints.h"
+#include "Sort.h"
+#include "Instrument.h"
 
 template <class ColType = Num, class ValType = double>
 class Divide
 {
-    std::vector<std::pair<double, ValType>> list;
-    typedef std::pair<double, ValType> pair_type;
+    std::vector<ValType> list; // the values, sorted
     int step;
     ValType start, stop;
     double gain = 0;
     std::vector<ColType> ranges;
+    std::vector<int> range_starts; // index into list where each range begins
     double epsilon;
+    double trivial;
+
+    // Summaries reused across calls to divide(). left and right are only
+    // needed during a call's scan, so one pair serves the whole recursion;
+    // each depth owns two slots of pool for the halves it recurses into.
+    ColType left, right;
+    std::vector<ColType> pool;
 
     bool isDifferent(double x, double y, double epsilon)
     {
         return std::abs(x - y) >= epsilon;
     }
 
-    bool isDifferent(std::string x, std::string y, double epsilon)
+    bool isDifferent(const std::string &x, const std::string &y, double epsilon)
     {
         return x != y;
     }
 
-    std::string get_string(std::string x)
-    {
-        return x;
-    }
-
-    std::string get_string(double x)
+    // Summarizes list[low, high) into col; Nums take the range in one call
+    void summarize(ColType &col, int low, int high)
     {
-        return std::to_string(x);
-    }
-
-public:
-    std::vector<ColType> get_ranges() const
-    {
-        return ranges;
-    }
-
-    Divide(std::vector<double> x, std::vector<ValType> y)
-    {
-        if (x.size() != y.size())
-        {
-            std::cerr << "Error: Sizes must match.\n";
-            return;
-        }
-
-        for (int i = 0; i < x.size(); i++)
-            list.push_back(std::make_pair(x[i], y[i]));
-
-        std::sort(list.begin(), list.end(), [](pair_type x, pair_type y) { return x.second < y.second; });
-
-        ColType before;
-        for (ValType val : y)
-            before += get_string(val);
-
-        Num xCol;
-        for (double val : x)
-            xCol += get_string(val);
-
-        step = static_cast<int>(std::sqrt(list.size()));
-        epsilon = before.variety() * 0.3;
-        stop = list[list.size() - 1].second;
-        start = list[0].second;
-
-        divide(1, list.size(), before, 1);
+        col.reset();
+        if constexpr (std::is_same<ColType, Num>::value && std::is_same<ValType, double>::value)
+            col.add(list.data() + low, high - low);
+        else
+            for (int i = low; i < high; i++)
+                col.add(list[i]);
     }
 
-    double divide(double low, double high, ColType before, double rank)
+    /**
+     * Recursively splits list[low, high), whose summary is before.
+     *
+     * @param depth - Recursion depth, which picks this call's pool slots
+     */
+    double divide(int low, int high, const ColType &before, double rank, int depth)
     {
-        ColType left;
-        ColType right;
-        for (int i = low; i < high; i++)
-            right += get_string(list[i].second);
-
+        INSTRUMENT_COUNT("Divide::scanned", high - low);
         double best = before.variety();
         int cut = -1;
 
-        for (int j = low; j < high; j++)
+        // Only the scan is timed; the recursion below times its own
         {
-            left += get_string(list[j].second);
-            right -= get_string(list[j].second);
+            INSTRUMENT_SCOPE("Divide::divide");
+            summarize(right, low, high);
+            left.reset();
 
-            if (left.size() >= step && right.size() >= step)
+            for (int j = low; j < high - 1; j++)
             {
-                ValType now = list[j - 1].second;
-                ValType after = list[j].second;
+                left.add(list[j]);
+                right.remove(list[j]);
 
-                if (now == after)
-                    continue;
-
-                if (right.isGreater(left, epsilon) &&
-                    isDifferent(after, start, epsilon) &&
-                    isDifferent(stop, now, epsilon))
+                // Try the cut before j + 1: left holds list[low, j] and
+                // right holds the rest, as they will after the cut
+                if (left.size() >= step && right.size() >= step)
                 {
-                    int n = left.size() + right.size();
-                    double expect = left.size() / n * left.variety() + right.size() / n * right.variety();
+                    const ValType &now = list[j];
+                    const ValType &after = list[j + 1];
+
+                    if (now == after)
+                        continue;
 
-                    if (expect * 1.025 < best)
+                    if (right.isGreater(left, epsilon) &&
+                        isDifferent(after, start, epsilon) &&
+                        isDifferent(stop, now, epsilon))
                     {
-                        best = expect;
-                        cut = j;
+                        double n = left.size() + right.size();
+                        double expect = left.size() / n * left.variety() + right.size() / n * right.variety();
+
+                        if (expect * trivial < best)
+                        {
+                            best = expect;
+                            cut = j + 1;
+                        }
                     }
                 }
             }
@@ -116,23 +103,91 @@ public:
 
         if (cut != -1)
         {
-            ColType ls, rs;
+            ColType &ls = pool[2 * depth];
+            ColType &rs = pool[2 * depth + 1];
+            summarize(ls, low, cut);
+            summarize(rs, cut, high);
 
-            for (int i = low; i < cut; i++)
-                ls += get_string(list[i].second);
-            for (int i = cut; i < high; i++)
-                rs += get_string(list[i].second);
-
-            rank = divide(low, cut, ls, rank) + 1;
-            rank = divide(cut, high, rs, rank);
+            rank = divide(low, cut, ls, rank, depth + 1) + 1;
+            rank = divide(cut, high, rs, rank, depth + 1);
         }
         else
         {
             gain += before.size() * before.variety();
             ranges.push_back(before);
+            range_starts.push_back(low);
         }
         return rank;
     }
+
+public:
+    const std::vector<ColType> &get_ranges() const
+    {
+        return ranges;
+    }
+
+    /**
+     * Returns the learned ranges as a reusable model: one boundary at the
+     * first (sorted) value of every range but the first. Applying the model
+     * to the training values puts each one in the bin of its range.
+     */
+    CutPoints get_cuts() const
+    {
+        static_assert(std::is_arithmetic<ValType>::value,
+                      "Cut points need numeric values");
+
+        std::vector<double> cuts;
+        for (size_t i = 1; i < range_starts.size(); i++)
+            cuts.push_back(list[range_starts[i]]);
+
+        return CutPoints(cuts);
+    }
+
+    /**
+     * @param cohen - Ranges must differ by at least this many standard
+     *                deviations (or entropies) of the whole list
+     * @param size - Ranges hold at least n^size values
+     * @param trivial - A cut must shrink the expected variety by this factor
+     */
+    Divide(const std::vector<double> &x, const std::vector<ValType> &y,
+           double cohen = 0.3, double size = 0.5, double trivial = 1.025)
+        : trivial(trivial)
+    {
+        if (x.size() != y.size())
+        {
+            std::cerr << "Error: Sizes must match.\n";
+            return;
+        }
+
+        // Sort through an argsort, so doubles take the radix path and
+        // already sorted input is just copied
+        {
+            INSTRUMENT_SCOPE("Divide::sort");
+            std::vector<uint32_t> order = Sort::argsort(y);
+            list.reserve(y.size());
+            for (uint32_t i : order)
+                list.push_back(y[i]);
+        }
+
+        ColType before;
+        summarize(before, 0, list.size());
+
+        // Both sides of a cut hold at least step values, and at least 2
+        step = std::max(2, static_cast<int>(std::pow(list.size(), size)));
+        epsilon = before.variety() * cohen;
+        stop = list[list.size() - 1];
+        start = list[0];
+
+        // Both sides of a cut hold at least step values, so there are at
+        // most n / step levels and ranges. Sizing everything up front keeps
+        // pool from moving while divide() holds references into it.
+        size_t most = list.size() / step + 2;
+        pool.resize(2 * most);
+        ranges.reserve(most);
+        range_starts.reserve(most);
+
+        divide(1, list.size(), before, 1, 0);
+    }
 };
 
-#endif
\ No newline at end of file
+#endif
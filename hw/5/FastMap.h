@@ -0,0 +1,219 @@
+#ifndef FAST_MAP_H
+#define FAST_MAP_H
+
+#include "Distance.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <numeric>
+#include <queue>
+#include <random>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/**
+ * Approximate nearest-row index built with FastMap projections. Each node
+ * picks two distant rows (east and west), projects its rows onto the line
+ * between them by the cosine rule, and splits at the median projection,
+ * until nodes hold at most leaf_size rows. A query follows its own
+ * projection down to a leaf and scans it, plus a few neighbouring leaves.
+ *
+ * Nodes live in one array in preorder: a node's left child comes right
+ * after it, and it stores the index of its right child. Since every split
+ * is at the median, the shape of the tree depends only on the number of
+ * rows, so the subtrees can be built on separate threads straight into
+ * their own slots.
+ */
+class FastMap
+{
+    struct Node
+    {
+        int east = -1, west = -1; // pivot rows; -1 in leaves
+        double c = 0;             // distance between the pivots
+        double cut = 0;           // median projection
+        size_t right = 0;         // index of the right child
+        size_t begin = 0, end = 0; // this node's rows are order[begin, end)
+    };
+
+    const Distance &distance;
+    std::vector<Node> nodes;
+    std::vector<uint32_t> order;
+    size_t leaf_size;
+    size_t samples;
+
+    // Number of nodes in a subtree over m rows
+    size_t count(size_t m) const
+    {
+        return m <= leaf_size ? 1 : 1 + count(m / 2) + count(m - m / 2);
+    }
+
+    static double project(double a, double b, double c)
+    {
+        return c > 0 ? (a * a + c * c - b * b) / (2 * c) : a;
+    }
+
+    // Returns the row (from a sample of order[begin, end)) farthest from q
+    int farthest(const Distance::Point &q, const std::vector<uint32_t> &sample) const
+    {
+        std::vector<double> d(sample.size());
+        distance.dists(q, sample.data(), sample.size(), d.data());
+        return sample[std::max_element(d.begin(), d.end()) - d.begin()];
+    }
+
+    void build(size_t node, size_t begin, size_t end, int spawn_depth, unsigned seed)
+    {
+        Node &nd = nodes[node];
+        nd.begin = begin;
+        nd.end = end;
+
+        size_t m = end - begin;
+        if (m <= leaf_size)
+            return;
+
+        // Pick far-apart pivots from a sample of the rows
+        std::mt19937 rng(seed + node);
+        std::vector<uint32_t> sample;
+        for (size_t i = 0; i < std::min(samples, m); i++)
+            sample.push_back(order[begin + rng() % m]);
+
+        nd.east = farthest(distance.point(sample[0]), sample);
+        Distance::Point east = distance.point(nd.east);
+        nd.west = farthest(east, sample);
+        Distance::Point west = distance.point(nd.west);
+        nd.c = distance.dist(east, nd.west);
+
+        // Project every row and split at the median
+        std::vector<double> a(m), b(m);
+        distance.dists(east, &order[begin], m, a.data());
+        distance.dists(west, &order[begin], m, b.data());
+
+        std::vector<std::pair<double, uint32_t>> proj(m);
+        for (size_t i = 0; i < m; i++)
+            proj[i] = std::make_pair(project(a[i], b[i], nd.c), order[begin + i]);
+
+        size_t half = m / 2;
+        std::nth_element(proj.begin(), proj.begin() + half, proj.end());
+        nd.cut = proj[half].first;
+        for (size_t i = 0; i < m; i++)
+            order[begin + i] = proj[i].second;
+
+        size_t mid = begin + half;
+        size_t left = node + 1;
+        nd.right = left + count(half);
+
+        if (spawn_depth > 0)
+        {
+            std::thread worker(&FastMap::build, this, nd.right, mid, end, spawn_depth - 1, seed);
+            build(left, begin, mid, spawn_depth - 1, seed);
+            worker.join();
+        }
+        else
+        {
+            build(left, begin, mid, 0, seed);
+            build(nd.right, mid, end, 0, seed);
+        }
+    }
+
+public:
+    /**
+     * @param distance - Distances over the table; must outlive the index
+     * @param leaf_size - Most rows in a leaf
+     * @param samples - Rows sampled per node when picking pivots
+     * @param threads - Number of threads; 0 means one per core
+     * @param seed - Seed for the pivot samples
+     */
+    FastMap(const Distance &distance, size_t leaf_size = 64, size_t samples = 128,
+            unsigned threads = 0, unsigned seed = 1)
+        : distance(distance), leaf_size(std::max<size_t>(leaf_size, 1)), samples(std::max<size_t>(samples, 1))
+    {
+        size_t n = distance.size();
+        order.resize(n);
+        std::iota(order.begin(), order.end(), 0);
+        nodes.resize(count(n));
+
+        // Split the top levels of the tree across threads
+        int spawn_depth = 0;
+        while ((1u << spawn_depth) < thread_count(threads))
+            spawn_depth++;
+
+        if (n > 0)
+            build(0, 0, n, spawn_depth, seed);
+    }
+
+    size_t size() const
+    {
+        return nodes.size();
+    }
+
+    // The rows, reordered so that every leaf is a contiguous range
+    const std::vector<uint32_t> &get_order() const
+    {
+        return order;
+    }
+
+    // The [begin, end) range of get_order() held by each leaf, left to right
+    std::vector<std::pair<size_t, size_t>> get_leaves() const
+    {
+        std::vector<std::pair<size_t, size_t>> leaves;
+        for (const Node &nd : nodes)
+            if (nd.east < 0)
+                leaves.push_back(std::make_pair(nd.begin, nd.end));
+        return leaves;
+    }
+
+    /**
+     * Approximate k nearest rows to a point. The search first follows the
+     * point's own projection down to a leaf, then visits up to probes - 1
+     * more leaves, always taking the untried branch whose cut was closest
+     * to the point's projection.
+     *
+     * @param probes - Number of leaves to scan
+     * @return (distance, row) pairs, nearest first
+     */
+    std::vector<std::pair<double, uint32_t>> nearest(const Distance::Point &q, size_t k, size_t probes = 8) const
+    {
+        std::vector<std::pair<double, uint32_t>> out;
+        if (order.empty())
+            return out;
+
+        // Untried branches, keyed by how far the point was from their cut
+        typedef std::pair<double, size_t> branch;
+        std::priority_queue<branch, std::vector<branch>, std::greater<branch>> pending;
+        pending.push(std::make_pair(0.0, size_t(0)));
+
+        std::vector<double> d;
+        for (size_t visited = 0; visited < probes && !pending.empty(); visited++)
+        {
+            size_t node = pending.top().second;
+            pending.pop();
+
+            while (nodes[node].east >= 0)
+            {
+                const Node &nd = nodes[node];
+                double x = project(distance.dist(q, nd.east), distance.dist(q, nd.west), nd.c);
+                bool left = x < nd.cut;
+
+                pending.push(std::make_pair(std::abs(x - nd.cut), left ? nd.right : node + 1));
+                node = left ? node + 1 : nd.right;
+            }
+
+            const Node &leaf = nodes[node];
+            size_t m = leaf.end - leaf.begin;
+            d.resize(m);
+            distance.dists(q, &order[leaf.begin], m, d.data());
+
+            for (size_t i = 0; i < m; i++)
+                out.push_back(std::make_pair(d[i], order[leaf.begin + i]));
+        }
+
+        k = std::min(k, out.size());
+        std::partial_sort(out.begin(), out.begin() + k, out.end());
+        out.resize(k);
+        return out;
+    }
+};
+
+#endif
@@ -0,0 +1,355 @@
+#ifndef GENERATOR_H
+#define GENERATOR_H
+
+#include "Parallel.h"
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/**
+ * Synthetic tables in the repo's CSV dialect, for benchmarks: Num columns
+ * ($), Sym columns, ignored columns (?), numeric goals (< and >), a class
+ * (!), missing cells (?) and # comments.
+ *
+ * Every row first draws its class (the majority class gets `balance` of
+ * the rows, the rest share what's left), then draws each Num from a normal
+ * distribution around a per-class mean and each Sym from a per-class skew,
+ * so the class can be learned from the other columns.
+ *
+ * Row i is drawn from its own stream of random numbers, seeded by the seed
+ * and i, so the output only depends on the options. That lets blocks of
+ * rows be formatted on separate threads and written in order.
+ *
+ * write_binary() writes the same rows column by column instead; see
+ * Columns(std::FILE *) for the format.
+ */
+class Generator
+{
+public:
+    struct Options
+    {
+        size_t rows = 1000;
+        int nums = 4;           // Num columns
+        int syms = 2;           // Sym columns
+        int cardinality = 5;    // symbols per Sym column
+        int classes = 2;
+        double balance = 0.5;   // fraction of rows in the first class
+        double missing = 0;     // fraction of missing cells
+        int skips = 0;          // ignored (?) columns
+        int goals = 0;          // numeric goals, alternately < and >
+        double comments = 0;    // fraction of rows with a trailing comment
+        uint64_t seed = 1;
+    };
+
+private:
+    Options opt;
+    std::vector<double> means; // [class][num]
+
+    static constexpr size_t BLOCK = 16384;
+
+    // splitmix64 (Steele, Lea and Flood)
+    struct Random
+    {
+        uint64_t state;
+
+        uint64_t next()
+        {
+            uint64_t z = (state += 0x9e3779b97f4a7c15ull);
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+            return z ^ (z >> 31);
+        }
+
+        double unit()
+        {
+            return (next() >> 11) * 0x1.0p-53;
+        }
+
+        int below(int n)
+        {
+            return static_cast<int>(((next() >> 32) * static_cast<uint64_t>(n)) >> 32);
+        }
+
+        // Roughly normal: the sum of four uniforms, rescaled
+        double normal()
+        {
+            return (unit() + unit() + unit() + unit() - 2) * 1.7320508075688772;
+        }
+    };
+
+    // One drawn row; goals and cells follow the column order of header()
+    struct Cells
+    {
+        int klass;
+        std::vector<double> nums, goals;
+        std::vector<int> syms, skips;
+        std::vector<bool> num_missing, sym_missing;
+        bool comment;
+    };
+
+    Random stream(size_t row) const
+    {
+        Random r{opt.seed * 0x2545f4914f6cdd1dull + row};
+        r.next();
+        return r;
+    }
+
+    void draw(size_t row, Cells &c) const
+    {
+        Random r = stream(row);
+
+        double u = r.unit();
+        c.klass = (u < opt.balance || opt.classes < 2)
+                      ? 0
+                      : 1 + std::min<int>((u - opt.balance) / (1 - opt.balance) * (opt.classes - 1), opt.classes - 2);
+
+        c.nums.resize(opt.nums);
+        c.num_missing.resize(opt.nums);
+        for (int j = 0; j < opt.nums; j++)
+        {
+            c.nums[j] = means[c.klass * opt.nums + j] + r.normal();
+            c.num_missing[j] = r.unit() < opt.missing;
+        }
+
+        // Each class favours one symbol per column, half the time
+        c.syms.resize(opt.syms);
+        c.sym_missing.resize(opt.syms);
+        for (int j = 0; j < opt.syms; j++)
+        {
+            int favourite = (c.klass * 7 + j * 3) % opt.cardinality;
+            c.syms[j] = r.unit() < 0.5 ? favourite : r.below(opt.cardinality);
+            c.sym_missing[j] = r.unit() < opt.missing;
+        }
+
+        c.skips.resize(opt.skips);
+        for (int j = 0; j < opt.skips; j++)
+            c.skips[j] = r.below(1000);
+
+        c.goals.resize(opt.goals);
+        for (int j = 0; j < opt.goals; j++)
+            c.goals[j] = 10 * c.klass + r.normal();
+
+        c.comment = r.unit() < opt.comments;
+    }
+
+    // Writes val with three decimals; faster than the general to_chars()
+    static void put(std::string &out, double val)
+    {
+        char buf[32];
+        char *p = buf;
+        long long milli = std::llround(val * 1000);
+        if (milli < 0)
+        {
+            *p++ = '-';
+            milli = -milli;
+        }
+
+        p = std::to_chars(p, buf + sizeof(buf), milli / 1000).ptr;
+        int frac = milli % 1000;
+        *p++ = '.';
+        *p++ = '0' + frac / 100;
+        *p++ = '0' + frac / 10 % 10;
+        *p++ = '0' + frac % 10;
+        out.append(buf, p);
+    }
+
+    static void put(std::string &out, const char *prefix, int val)
+    {
+        char buf[16];
+        char *end = std::to_chars(buf, buf + sizeof(buf), val).ptr;
+        out += prefix;
+        out.append(buf, end);
+    }
+
+    void format(size_t begin, size_t end, std::string &out) const
+    {
+        out.clear();
+        Cells c;
+        for (size_t i = begin; i < end; i++)
+        {
+            draw(i, c);
+
+            for (int j = 0; j < opt.nums; j++)
+            {
+                if (c.num_missing[j])
+                    out += "?";
+                else
+                    put(out, c.nums[j]);
+                out += ",";
+            }
+            for (int j = 0; j < opt.syms; j++)
+            {
+                if (c.sym_missing[j])
+                    out += "?";
+                else
+                    put(out, "v", c.syms[j]);
+                out += ",";
+            }
+            for (int j = 0; j < opt.skips; j++)
+            {
+                put(out, "", c.skips[j]);
+                out += ",";
+            }
+            for (int j = 0; j < opt.goals; j++)
+            {
+                put(out, c.goals[j]);
+                out += ",";
+            }
+            put(out, "c", c.klass);
+            out += c.comment ? " # synthetic\n" : "\n";
+        }
+    }
+
+    template <class T>
+    static void write(std::FILE *out, const T &val)
+    {
+        std::fwrite(&val, sizeof(T), 1, out);
+    }
+
+    static void write(std::FILE *out, const std::string &text)
+    {
+        write(out, static_cast<uint32_t>(text.size()));
+        std::fwrite(text.data(), 1, text.size(), out);
+    }
+
+public:
+    Generator(const Options &options) : opt(options)
+    {
+        opt.cardinality = std::max(opt.cardinality, 1);
+        opt.classes = std::max(opt.classes, 1);
+
+        // Class means a couple of standard deviations apart
+        Random r{opt.seed};
+        means.resize(opt.classes * opt.nums);
+        for (double &mean : means)
+            mean = 4 * r.unit();
+    }
+
+    std::string header() const
+    {
+        std::string line;
+        for (int j = 0; j < opt.nums; j++)
+            put(line, "$n", j), line += ",";
+        for (int j = 0; j < opt.syms; j++)
+            put(line, "s", j), line += ",";
+        for (int j = 0; j < opt.skips; j++)
+            put(line, "?skip", j), line += ",";
+        for (int j = 0; j < opt.goals; j++)
+            put(line, j % 2 ? ">g" : "<g", j), line += ",";
+        return line + "!class";
+    }
+
+    /**
+     * Writes the CSV: a comment, the header, and the rows.
+     *
+     * @param threads - Number of threads formatting rows; 0 means one per core
+     * @return Bytes written
+     */
+    size_t write_csv(std::FILE *out, unsigned threads = 0) const
+    {
+        std::string head = "# synthetic data, seed " + std::to_string(opt.seed) + "\n" + header() + "\n";
+        std::fwrite(head.data(), 1, head.size(), out);
+        size_t bytes = head.size();
+
+        // Each round formats one block per thread, then writes them in order
+        unsigned t = thread_count(threads);
+        std::vector<std::string> blocks(t);
+        for (size_t start = 0; start < opt.rows; start += t * BLOCK)
+        {
+            parallel_for(t, t, [&](size_t begin, size_t end, unsigned) {
+                for (size_t b = begin; b < end; b++)
+                {
+                    size_t low = std::min(opt.rows, start + b * BLOCK);
+                    size_t high = std::min(opt.rows, low + BLOCK);
+                    format(low, high, blocks[b]);
+                }
+            });
+
+            for (const std::string &block : blocks)
+            {
+                std::fwrite(block.data(), 1, block.size(), out);
+                bytes += block.size();
+            }
+        }
+        return bytes;
+    }
+
+    /**
+     * Writes the same table in binary, column by column within groups of
+     * rows. The ignored columns are left out, since readers drop them.
+     */
+    void write_binary(std::FILE *out, unsigned threads = 0) const
+    {
+        std::fwrite("TBLC", 1, 4, out);
+        write(out, static_cast<uint32_t>(opt.nums + opt.syms + opt.goals + 1));
+
+        std::vector<std::string> symbols, classes;
+        for (int v = 0; v < opt.cardinality; v++)
+            symbols.push_back("v" + std::to_string(v));
+        for (int k = 0; k < opt.classes; k++)
+            classes.push_back("c" + std::to_string(k));
+
+        // Columns: kind (0 Num, 1 Sym), goal flag, name, and symbols
+        auto column = [&](uint8_t kind, uint8_t goal, const std::string &name,
+                          const std::vector<std::string> &names) {
+            write(out, kind);
+            write(out, goal);
+            write(out, name);
+            if (kind == 1)
+            {
+                write(out, static_cast<uint32_t>(names.size()));
+                for (const std::string &text : names)
+                    write(out, text);
+            }
+        };
+
+        for (int j = 0; j < opt.nums; j++)
+            column(0, 0, "$n" + std::to_string(j), symbols);
+        for (int j = 0; j < opt.syms; j++)
+            column(1, 0, "s" + std::to_string(j), symbols);
+        for (int j = 0; j < opt.goals; j++)
+            column(0, 1, (j % 2 ? ">g" : "<g") + std::to_string(j), symbols);
+        column(1, 1, "!class", classes);
+
+        // Groups: row count, then every column's values (doubles with NaN
+        // for Nums, int32 ids with -1 for Syms); a count of 0 ends the file
+        size_t group = thread_count(threads) * BLOCK;
+        std::vector<std::vector<double>> nums(opt.nums + opt.goals, std::vector<double>(group));
+        std::vector<std::vector<int32_t>> syms(opt.syms + 1, std::vector<int32_t>(group));
+
+        for (size_t start = 0; start < opt.rows; start += group)
+        {
+            size_t m = std::min(group, opt.rows - start);
+            parallel_for(m, threads, [&](size_t begin, size_t end, unsigned) {
+                Cells c;
+                for (size_t i = begin; i < end; i++)
+                {
+                    draw(start + i, c);
+                    for (int j = 0; j < opt.nums; j++)
+                        nums[j][i] = c.num_missing[j] ? std::nan("") : c.nums[j];
+                    for (int j = 0; j < opt.goals; j++)
+                        nums[opt.nums + j][i] = c.goals[j];
+                    for (int j = 0; j < opt.syms; j++)
+                        syms[j][i] = c.sym_missing[j] ? -1 : c.syms[j];
+                    syms[opt.syms][i] = c.klass;
+                }
+            });
+
+            write(out, static_cast<uint64_t>(m));
+            for (int j = 0; j < opt.nums; j++)
+                std::fwrite(nums[j].data(), sizeof(double), m, out);
+            for (int j = 0; j < opt.syms; j++)
+                std::fwrite(syms[j].data(), sizeof(int32_t), m, out);
+            for (int j = 0; j < opt.goals; j++)
+                std::fwrite(nums[opt.nums + j].data(), sizeof(double), m, out);
+            std::fwrite(syms[opt.syms].data(), sizeof(int32_t), m, out);
+        }
+        write(out, static_cast<uint64_t>(0));
+    }
+};
+
+#endif
@@ -0,0 +1,266 @@
+#ifndef INSTRUMENT_H
+#define INSTRUMENT_H
+
+/**
+ * Scoped timers and counters for the hot paths, compiled in only with
+ * -DINSTRUMENT. Without it the macros below expand to nothing.
+ *
+ *     INSTRUMENT_SCOPE("Tbl::parse");      // times the rest of the block
+ *     INSTRUMENT_COUNT("Tbl::rows", 1);    // adds to a counter
+ *
+ * Each thread records into its own buffer, so probes take no locks: a
+ * probe is two reads of the cycle counter and a few adds, and the first
+ * probe of a site pays once to look up its name. At exit the buffers are
+ * summed into a table on stderr (calls, total and mean time, and counts,
+ * per site and over all threads) and the timed scopes are written as a
+ * Chrome trace (chrome://tracing or ui.perfetto.dev) to the file named by
+ * INSTRUMENT_TRACE, or instrument.json. Each thread keeps its first
+ * Instrument::MAX_EVENTS scopes for the trace; the summary counts them all.
+ * A scope's time includes the scopes nested in it.
+ */
+#ifdef INSTRUMENT
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+class Instrument
+{
+public:
+    static constexpr size_t MAX_EVENTS = 1 << 20;
+
+    static uint64_t now()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+
+    struct Stats
+    {
+        uint64_t calls = 0;
+        uint64_t ticks = 0;
+        uint64_t count = 0;
+    };
+
+    struct Event
+    {
+        int site;
+        uint64_t start, stop;
+    };
+
+    // One thread's records; only that thread writes to it
+    struct Buffer
+    {
+        int tid;
+        std::vector<Stats> stats; // [site]
+        std::vector<Event> events;
+
+        Stats &at(int site)
+        {
+            if (static_cast<size_t>(site) >= stats.size())
+                stats.resize(site + 1);
+            return stats[site];
+        }
+    };
+
+private:
+    struct Registry
+    {
+        std::mutex lock;
+        std::vector<std::string> names; // [site]
+        std::vector<Buffer *> buffers;  // kept until exit, past their threads
+        uint64_t start_ticks;
+        std::chrono::steady_clock::time_point start_time;
+
+        Registry() : start_ticks(now()), start_time(std::chrono::steady_clock::now())
+        {
+            std::atexit(dump);
+        }
+    };
+
+    // Never destroyed, so it outlives the exit handler and the other threads
+    static Registry &registry()
+    {
+        static Registry *r = new Registry();
+        return *r;
+    }
+
+    static Buffer *make_buffer()
+    {
+        Registry &r = registry();
+        std::lock_guard<std::mutex> guard(r.lock);
+        Buffer *b = new Buffer();
+        b->tid = r.buffers.size();
+        b->events.reserve(1024);
+        r.buffers.push_back(b);
+        return b;
+    }
+
+    static std::string json_escape(const std::string &text)
+    {
+        std::string out;
+        for (char c : text)
+        {
+            if (c == '"' || c == '\\')
+                out += '\\';
+            out += c;
+        }
+        return out;
+    }
+
+public:
+    // Id of a probe site; sites with the same name share an id
+    static int site(const char *name)
+    {
+        Registry &r = registry();
+        std::lock_guard<std::mutex> guard(r.lock);
+        auto it = std::find(r.names.begin(), r.names.end(), name);
+        if (it != r.names.end())
+            return it - r.names.begin();
+
+        r.names.push_back(name);
+        return r.names.size() - 1;
+    }
+
+    static Buffer &buffer()
+    {
+        static thread_local Buffer *local = make_buffer();
+        return *local;
+    }
+
+    static void record(int site, uint64_t start, uint64_t stop)
+    {
+        Buffer &b = buffer();
+        Stats &s = b.at(site);
+        ++s.calls;
+        s.ticks += stop - start;
+        if (b.events.size() < MAX_EVENTS)
+            b.events.push_back(Event{site, start, stop});
+    }
+
+    static void count(int site, uint64_t n)
+    {
+        buffer().at(site).count += n;
+    }
+
+    // Times its enclosing scope
+    class Scope
+    {
+        int id;
+        uint64_t start;
+
+    public:
+        explicit Scope(int id) : id(id), start(now()) {}
+
+        ~Scope()
+        {
+            record(id, start, now());
+        }
+    };
+
+    /**
+     * Writes the summary and the trace. Runs at exit, once the other
+     * threads are done; call it earlier only when no probes are running.
+     */
+    static void dump()
+    {
+        Registry &r = registry();
+        std::lock_guard<std::mutex> guard(r.lock);
+
+        // Cycles per nanosecond, measured over the life of the program
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - r.start_time).count();
+        double per_ns = ns > 0 ? (now() - r.start_ticks) / ns : 1;
+        if (per_ns <= 0)
+            per_ns = 1;
+
+        std::vector<Stats> total(r.names.size());
+        std::vector<int> threads(r.names.size(), 0);
+        for (const Buffer *b : r.buffers)
+        {
+            for (size_t i = 0; i < b->stats.size(); i++)
+            {
+                total[i].calls += b->stats[i].calls;
+                total[i].ticks += b->stats[i].ticks;
+                total[i].count += b->stats[i].count;
+                threads[i] += b->stats[i].calls > 0 || b->stats[i].count > 0;
+            }
+        }
+
+        std::vector<size_t> order;
+        for (size_t i = 0; i < total.size(); i++)
+            order.push_back(i);
+        std::stable_sort(order.begin(), order.end(),
+                         [&](size_t a, size_t b) { return total[a].ticks > total[b].ticks; });
+
+        std::fprintf(stderr, "%-28s %8s %12s %12s %10s %12s\n", "site", "threads", "calls", "total ms", "ns/call", "count");
+        for (size_t i : order)
+        {
+            const Stats &s = total[i];
+            std::fprintf(stderr, "%-28s %8d %12llu %12.3f %10.1f %12llu\n", r.names[i].c_str(), threads[i],
+                         static_cast<unsigned long long>(s.calls), s.ticks / per_ns / 1e6,
+                         s.calls ? s.ticks / per_ns / s.calls : 0.0, static_cast<unsigned long long>(s.count));
+        }
+
+        const char *path = std::getenv("INSTRUMENT_TRACE");
+        path = path ? path : "instrument.json";
+        std::FILE *out = std::fopen(path, "w");
+        if (!out)
+        {
+            std::fprintf(stderr, "Error: can't open %s\n", path);
+            return;
+        }
+
+        // Complete ("X") events, in microseconds since the start
+        std::fprintf(out, "{\"traceEvents\":[");
+        bool first = true;
+        for (const Buffer *b : r.buffers)
+        {
+            for (const Event &e : b->events)
+            {
+                std::fprintf(out, "%s\n{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                             first ? "" : ",", json_escape(r.names[e.site]).c_str(), b->tid,
+                             (e.start - r.start_ticks) / per_ns / 1e3, (e.stop - e.start) / per_ns / 1e3);
+                first = false;
+            }
+        }
+        std::fprintf(out, "\n],\"displayTimeUnit\":\"ns\"}\n");
+        std::fclose(out);
+    }
+};
+
+#define INSTRUMENT_CAT_(a, b) a##b
+#define INSTRUMENT_CAT(a, b) INSTRUMENT_CAT_(a, b)
+#define INSTRUMENT_SCOPE(name)                                                                  \
+    static const int INSTRUMENT_CAT(instrument_site_, __LINE__) = Instrument::site(name);       \
+    Instrument::Scope INSTRUMENT_CAT(instrument_scope_, __LINE__)(INSTRUMENT_CAT(instrument_site_, __LINE__))
+#define INSTRUMENT_COUNT(name, n)                                                \
+    do                                                                           \
+    {                                                                            \
+        static const int instrument_site = Instrument::site(name);               \
+        Instrument::count(instrument_site, n);                                   \
+    } while (0)
+
+#else
+
+#define INSTRUMENT_SCOPE(name)
+#define INSTRUMENT_COUNT(name, n) \
+    do                            \
+    {                             \
+    } while (0)
+
+#endif
+
+#endif
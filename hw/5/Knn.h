@@ -0,0 +1,107 @@
+#ifndef KNN_H
+#define KNN_H
+
+#include "Tbl.h"
+#include "Distance.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <map>
+#include <numeric>
+#include <string>
+#include <vector>
+
+/**
+ * k-nearest-neighbour classifier over a Tbl. The class is the table's
+ * classification column (the last goal); distances come from Distance.
+ */
+class Knn
+{
+    Distance distance;
+    std::vector<int> labels; // class id of each row
+    std::vector<std::string> classes;
+    int k;
+
+    // Majority vote among the k nearest rows, skipping row `skip`
+    std::string vote(const std::vector<double> &dists, size_t skip) const
+    {
+        std::vector<size_t> idx(dists.size());
+        std::iota(idx.begin(), idx.end(), 0);
+        if (skip < idx.size())
+            idx.erase(idx.begin() + skip);
+
+        size_t m = std::min<size_t>(k, idx.size());
+        if (m == 0)
+            return "";
+
+        std::nth_element(idx.begin(), idx.begin() + (m - 1), idx.end(),
+                         [&](size_t a, size_t b) { return dists[a] < dists[b]; });
+        std::sort(idx.begin(), idx.begin() + m,
+                  [&](size_t a, size_t b) { return dists[a] < dists[b]; });
+
+        // Ties go to the class of the nearer neighbour
+        std::vector<int> votes(classes.size(), 0);
+        int best = labels[idx[0]];
+        for (size_t i = 0; i < m; i++)
+        {
+            int label = labels[idx[i]];
+            if (++votes[label] > votes[best])
+                best = label;
+        }
+
+        return classes[best];
+    }
+
+public:
+    /**
+     * @param tbl - The training table; its rows are copied
+     * @param k - Number of neighbours
+     * @param p - The Minkowski exponent for distances
+     */
+    Knn(const Tbl &tbl, int k = 5, double p = 2) : distance(tbl, p), k(k)
+    {
+        std::vector<int> goals = tbl.get_goals();
+        if (goals.size() == 0)
+            throw "Error: No goals\n";
+
+        int target = goals[goals.size() - 1];
+        std::map<std::string, int> ids;
+        for (const Row &row : tbl.get_rows())
+        {
+            const std::string &label = row.get_cells()[target];
+            auto it = ids.emplace(label, classes.size());
+            if (it.second)
+                classes.push_back(label);
+            labels.push_back(it.first->second);
+        }
+    }
+
+    // Classifies a row from outside the table
+    std::string classify(const Row &row) const
+    {
+        return vote(distance.dists(distance.point(row)), -1);
+    }
+
+    // Classifies row i of the training table from its other rows
+    std::string classify(size_t i) const
+    {
+        return vote(distance.dists(distance.point(i)), i);
+    }
+
+    /**
+     * Classifies many rows, splitting them across threads.
+     *
+     * @param threads - Number of threads; 0 means one per core
+     */
+    std::vector<std::string> classify(const std::vector<Row> &queries,
+                                      unsigned threads = 0) const
+    {
+        std::vector<std::string> out(queries.size());
+        parallel_for(queries.size(), threads, [&](size_t begin, size_t end, unsigned) {
+            for (size_t i = begin; i < end; i++)
+                out[i] = classify(queries[i]);
+        });
+        return out;
+    }
+};
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef LEARNER_H
+#define LEARNER_H
+
+#include "Row.h"
+#include <string>
+
+/**
+ * What every incremental classifier offers, so harnesses like CrossVal can
+ * train and test any of them. add_header() must come first.
+ *
+ * Learners take rows that are already parsed (see Tbl::parse()), so one
+ * parse of a line can feed several learners with the same header. The
+ * line versions parse with the learner's own header and are meant for a
+ * learner used on its own.
+ */
+class Learner
+{
+public:
+    virtual ~Learner() = default;
+
+    virtual void add_header(std::string line) = 0;
+
+    // Parses a CSV line into a row; false for blank or malformed lines
+    virtual bool parse(std::string line, Row &row) const = 0;
+
+    virtual void add_row(const Row &row) = 0;
+
+    // Returns the predicted class of a row
+    virtual std::string classify(const Row &row) = 0;
+
+    void add_row(std::string line)
+    {
+        Row row;
+        if (parse(line, row))
+            add_row(row);
+    }
+
+    std::string classify(std::string line)
+    {
+        Row row;
+        return parse(line, row) ? classify(row) : "";
+    }
+};
+
+#endif
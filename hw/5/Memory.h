@@ -0,0 +1,101 @@
+#ifndef MEMORY_H
+#define MEMORY_H
+
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+/**
+ * Estimates of the heap memory behind the standard containers, for the
+ * memory_usage() functions of Tbl, Col, NaiveBayes and Abcd. The estimates
+ * follow libstdc++ and glibc: strings keep up to 15 characters inline,
+ * tree nodes carry three pointers and a colour, and every heap block is
+ * rounded up to 16 bytes after an 8 byte header, with at least 32 bytes.
+ *
+ * heap() counts only what an object owns on the heap, not the object
+ * itself, so a member is sizeof(member) + heap(member) and a container of
+ * objects adds the heap() of each element.
+ */
+class Memory
+{
+public:
+    // Bytes glibc's malloc takes for an n byte request
+    static size_t block(size_t n)
+    {
+        if (n == 0)
+            return 0;
+
+        size_t chunk = (n + 8 + 15) & ~size_t(15);
+        return chunk < 32 ? 32 : chunk;
+    }
+
+    static size_t heap(const std::string &text)
+    {
+        return text.capacity() > 15 ? block(text.capacity() + 1) : 0;
+    }
+
+    template <class T>
+    static typename std::enable_if<std::is_arithmetic<T>::value, size_t>::type heap(T)
+    {
+        return 0;
+    }
+
+    // Classes that report their own memory_usage(), like Row and Tbl
+    template <class T>
+    static auto heap(const T &obj) -> decltype(obj.memory_usage())
+    {
+        return obj.memory_usage() - sizeof(T);
+    }
+
+    template <class A, class B>
+    static size_t heap(const std::pair<A, B> &pair)
+    {
+        return heap(pair.first) + heap(pair.second);
+    }
+
+    template <class T>
+    static size_t heap(const std::vector<T> &list)
+    {
+        size_t bytes = block(list.capacity() * sizeof(T));
+        for (const T &item : list)
+            bytes += heap(item);
+        return bytes;
+    }
+
+    // vector<bool> packs its bits into words
+    static size_t heap(const std::vector<bool> &list)
+    {
+        return block((list.capacity() + 63) / 64 * 8);
+    }
+
+    template <class K, class V>
+    static size_t heap(const std::map<K, V> &map)
+    {
+        size_t bytes = map.size() * block(32 + sizeof(std::pair<const K, V>));
+        for (const std::pair<const K, V> &pair : map)
+            bytes += heap(pair.first) + heap(pair.second);
+        return bytes;
+    }
+
+    template <class T>
+    static size_t heap(const std::set<T> &set)
+    {
+        size_t bytes = set.size() * block(32 + sizeof(T));
+        for (const T &item : set)
+            bytes += heap(item);
+        return bytes;
+    }
+
+    // A shared_ptr made from new: the object, which reports its own size,
+    // and the separately allocated control block
+    template <class T>
+    static size_t heap(const std::shared_ptr<T> &ptr)
+    {
+        return ptr ? ptr->memory_usage() + block(24) : 0;
+    }
+};
+
+#endif
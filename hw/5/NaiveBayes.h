@@ -2,114 +2,580 @@
 #define NAIVE_BAYES_H
 
 #include "Tbl.h"
+#include "Divide.h"
+#include "CutPoints.h"
+#include "Learner.h"
+#include "Instrument.h"
+#include "Memory.h"
 #include <map>
 #include <string>
 #include <numeric>
 #include <algorithm>
-#include <boost/algorithm/string/split.hpp>
-#include <boost/algorithm/string/classification.hpp>
+#include <limits>
 
-class NaiveBayes
+class NaiveBayes : public Learner
 {
-    std::map<std::string, Tbl> class_tables;
+public:
+    /**
+     * GAUSSIAN scores numeric columns with a normal pdf. DISCRETIZED bins
+     * numeric columns with Divide and then treats every column as symbols,
+     * so scoring is a sum of precomputed log-counts.
+     */
+    enum Mode
+    {
+        GAUSSIAN,
+        DISCRETIZED
+    };
+
+    /**
+     * What predict() says about a row. Labels point into the model, so
+     * they stay valid until it learns a new class.
+     */
+    struct Scores
+    {
+        struct Class
+        {
+            int id;                   // see class_name()
+            const std::string *label;
+            double log_posterior; // up to a constant shared by all classes
+            double probability;   // normalized over all classes
+        };
+
+        std::vector<Class> top; // most likely first
+        double margin = 0;      // probability of the best class minus the
+                                // second best's; 1 with a single class
+    };
+
+private:
+    // Classes are interned to dense ids in order of first sight, and
+    // everything kept per class is a vector indexed by id.
+    std::map<std::string, int> class_ids;
+    std::vector<std::string> class_names; // by id
+    std::vector<Tbl> class_tables;        // by id; GAUSSIAN mode
     Tbl master_table;
     std::string header_line; // unprocessed header string
-    std::vector<int> skip_indices, nums, syms;
+    std::vector<int> nums, syms; // column indices, counting only kept columns
+    int target = -1; // the class column, which is never a feature
+    Mode mode;
 
-public:
-    void add_header(std::string line)
+    // Per-class counts of every feature value, used in DISCRETIZED mode.
+    struct Counts
     {
-        // We'll deal with the individual tables later.
-        master_table.add_header(line);
-        skip_indices = master_table.get_skip_columns();
-        nums = master_table.get_nums();
-        syms = master_table.get_syms();
-        header_line = line;
+        int rows = 0;
+        std::vector<std::vector<int>> counts; // [feature][bin or symbol]
+        std::vector<int> totals;              // [feature]; rows with a known value
+        std::vector<double> log_denoms;       // [feature]; log(totals + k * levels)
+
+        size_t memory_usage() const
+        {
+            return sizeof(Counts) + Memory::heap(counts) + Memory::heap(totals) + Memory::heap(log_denoms);
+        }
+    };
+
+    std::vector<int> features;                       // token index of each feature
+    std::vector<bool> is_num;                        // per feature
+    std::vector<CutPoints> cuts;                     // per feature; unused for syms
+    std::vector<std::map<std::string, int>> symbols; // per feature; unused for nums
+    std::vector<std::vector<double>> raw;            // per feature: training values or symbol ids
+    std::vector<int> row_classes;                    // class id of each training row
+    std::vector<Counts> class_counts;                // by class id
+    std::vector<double> log_ints;   // log_ints[i] = log(i)
+    std::vector<double> log_counts; // log_counts[i] = log(i + k)
+    size_t next_fit;                // refit the bins when this many rows are seen
+
+    // Reused by every call, so classifying doesn't allocate
+    std::vector<int> query; // bin or symbol id of each feature of the row
+    Scores scratch;         // for classify()
+
+    // Settings of DISCRETIZED mode; see the constructor
+    double k;
+    double cohen, size, trivial;
+
+    /**
+     * Returns the id of a class, giving it the next id if it hasn't been
+     * seen before. The class's storage is the caller's to create.
+     */
+    int intern(const std::string &class_name)
+    {
+        std::map<std::string, int>::iterator it = class_ids.lower_bound(class_name);
+        if (it != class_ids.end() && it->first == class_name)
+            return it->second;
+
+        int id = class_names.size();
+        class_ids.emplace_hint(it, class_name, id);
+        class_names.push_back(class_name);
+        return id;
     }
 
-    void print_num_stats()
+    static bool token_missing(const std::string &token)
+    {
+        return token == "?" || token.empty();
+    }
+
+    // Returns the bin or symbol id of a training value, -1 if missing.
+    int code(size_t f, double val) const
+    {
+        if (val != val)
+            return -1;
+
+        return is_num[f] ? cuts[f].bin(val) : static_cast<int>(val);
+    }
+
+    // Number of distinct values a feature can take, for Laplace smoothing.
+    int levels(size_t f) const
+    {
+        return is_num[f] ? cuts[f].bins() : std::max<int>(symbols[f].size(), 1);
+    }
+
+    void grow_log_ints(size_t n)
     {
-        for (const std::pair<std::string, Tbl>& pair : class_tables)
+        while (log_ints.size() <= n)
+            log_ints.push_back(log_ints.empty() ? 0 : std::log(log_ints.size()));
+        while (log_counts.size() <= n)
+            log_counts.push_back(std::log(log_counts.size() + k));
+    }
+
+    // Keeps the smoothed denominator of feature f in step with its counts
+    void set_log_denom(Counts &c, size_t f)
+    {
+        c.log_denoms[f] = std::log(c.totals[f] + k * levels(f));
+    }
+
+    void count_row(size_t r)
+    {
+        Counts &c = class_counts[row_classes[r]];
+
+        for (size_t f = 0; f < features.size(); f++)
         {
-            std::cout << pair.first << ":\n";
-            pair.second.print_num_stats();
-            std::cout << "\n";
+            int v = code(f, raw[f][r]);
+            if (v < 0)
+                continue;
+
+            if (static_cast<size_t>(v) >= c.counts[f].size())
+                c.counts[f].resize(v + 1, 0);
+            ++c.counts[f][v];
+            ++c.totals[f];
+            set_log_denom(c, f);
         }
     }
 
-    void add_row(std::string line)
+    /**
+     * Learns cut points for every numeric feature with Divide, then
+     * re-counts all training rows into the new bins.
+     */
+    void fit_bins()
     {
-        std::vector<std::string> tokens;
-        boost::split(tokens, line, boost::is_any_of(", "));
+        INSTRUMENT_SCOPE("NaiveBayes::fit_bins");
+        for (size_t f = 0; f < features.size(); f++)
+        {
+            if (!is_num[f])
+                continue;
 
-        if (tokens.size() == 0)
+            std::vector<double> known;
+            std::copy_if(raw[f].begin(), raw[f].end(), std::back_inserter(known),
+                         [](double val) { return val == val; });
+
+            if (known.size() < 2)
+                continue;
+
+            Divide<> div(known, known, cohen, size, trivial);
+            cuts[f] = div.get_cuts();
+        }
+
+        for (Counts &c : class_counts)
+        {
+            for (std::vector<int> &counts : c.counts)
+                counts.clear();
+            std::fill(c.totals.begin(), c.totals.end(), 0);
+        }
+
+        for (size_t r = 0; r < row_classes.size(); r++)
+            count_row(r);
+
+        // The bins changed, so every denominator did, counted or not
+        for (Counts &c : class_counts)
+            for (size_t f = 0; f < features.size(); f++)
+                set_log_denom(c, f);
+    }
+
+    void add_discrete_row(const Row &row)
+    {
+        const std::vector<std::string> &tokens = row.get_cells();
+        if (tokens.size() != nums.size() + syms.size())
             return;
 
-        std::string class_name = tokens[tokens.size() - 1];
+        for (size_t f = 0; f < features.size(); f++)
+        {
+            const std::string &token = tokens[features[f]];
+            if (is_num[f])
+            {
+                raw[f].push_back(row.get_num(features[f]));
+            }
+            else if (token_missing(token))
+            {
+                raw[f].push_back(std::numeric_limits<double>::quiet_NaN());
+            }
+            else
+            {
+                // Intern the symbol; ids are assigned in order of first sight.
+                // A new one adds a level to every class's denominator.
+                auto it = symbols[f].emplace(token, symbols[f].size());
+                raw[f].push_back(it.first->second);
+                if (it.second)
+                    for (Counts &c : class_counts)
+                        set_log_denom(c, f);
+            }
+        }
 
-        // If there's no table for the current class, create one.
-        if (class_tables.find(class_name) == class_tables.end())
+        int id = intern(tokens[tokens.size() - 1]);
+        if (static_cast<size_t>(id) == class_counts.size())
         {
-            class_tables[class_name] = Tbl();
-            class_tables[class_name].add_header(header_line);
+            class_counts.emplace_back();
+            class_counts[id].counts.resize(features.size());
+            class_counts[id].totals.resize(features.size(), 0);
+            class_counts[id].log_denoms.resize(features.size());
+            for (size_t f = 0; f < features.size(); f++)
+                set_log_denom(class_counts[id], f);
         }
+        ++class_counts[id].rows;
+        row_classes.push_back(id);
 
-        class_tables[class_name].add_row(line);
-        master_table.add_row(line);
+        // Refit at doubling sizes, so the total refit cost stays linear
+        if (row_classes.size() >= next_fit)
+        {
+            fit_bins();
+            next_fit = 2 * row_classes.size();
+        }
+        else
+            count_row(row_classes.size() - 1);
+
+        int max_levels = 0;
+        for (size_t f = 0; f < features.size(); f++)
+            max_levels = std::max(max_levels, levels(f));
+        grow_log_ints(row_classes.size() + max_levels + 1);
     }
 
-    std::string classify(std::string line)
+    /**
+     * Puts the log posterior of every class into scores.top, in class
+     * order. Returns false, leaving scores.top empty, if the row can't be
+     * scored.
+     */
+    bool score_discrete(const Row &row, Scores &scores)
     {
-        std::vector<std::string> tokens;
-        boost::split(tokens, line, boost::is_any_of(", "));
+        const std::vector<std::string> &tokens = row.get_cells();
+        if (tokens.size() != nums.size() + syms.size() ||
+            row_classes.empty())
+            return false;
 
-        if (tokens.size() == 0)
-            return "null";
+        // Turn the query into bins and symbol ids once, for all classes
+        query.resize(features.size());
+        for (size_t f = 0; f < features.size(); f++)
+        {
+            const std::string &token = tokens[features[f]];
+            if (is_num[f])
+            {
+                query[f] = cuts[f].bin(row.get_num(features[f]));
+            }
+            else if (token_missing(token))
+            {
+                query[f] = -1;
+            }
+            else
+            {
+                // Unseen symbols get -2: known, but never counted
+                auto it = symbols[f].find(token);
+                query[f] = (it == symbols[f].end()) ? -2 : it->second;
+            }
+        }
 
-        std::string most_likely_class = "";
-        double highest_log_posterior = -1e4;
+        const int ids = class_counts.size();
+        for (int id = 0; id < ids; id++)
+        {
+            const Counts &c = class_counts[id];
+            double log_posterior = log_ints[c.rows] - log_ints[row_classes.size()];
+
+            for (size_t f = 0; f < features.size(); f++)
+            {
+                int v = query[f];
+                if (v == -1)
+                    continue;
+
+                int count = (v >= 0 && static_cast<size_t>(v) < c.counts[f].size()) ? c.counts[f][v] : 0;
+                log_posterior += log_counts[count] - c.log_denoms[f];
+            }
+
+            scores.top.push_back({id, &class_names[id], log_posterior, 0});
+        }
+        return true;
+    }
+
+    // As score_discrete(), for GAUSSIAN mode
+    bool score_gaussian(const Row &row, Scores &scores) const
+    {
+        const std::vector<std::string> &tokens = row.get_cells();
 
-        for (const std::pair<std::string, Tbl>& pair : class_tables)
+        int total_rows = std::accumulate(class_tables.begin(),
+                                         class_tables.end(),
+                                         0, [](int prev, const Tbl &table) {
+                                             return prev + table.size();
+                                         });
+
+        const int ids = class_tables.size(), width = tokens.size();
+        for (int id = 0; id < ids; id++)
         {
+            const Tbl &table = class_tables[id];
+
             // Compute the prior
-            int total_rows = std::accumulate(class_tables.begin(),
-                                             class_tables.end(),
-                                             0, [](int prev, std::pair<std::string, Tbl> pair2) {
-                                                 return prev + pair2.second.size();
-                                             });
-            double prior = static_cast<double>(pair.second.size()) / total_rows;
+            double prior = static_cast<double>(table.size()) / total_rows;
 
             // Compute the likelihood
             double log_likelihood = 0;
-            for (int i = 0; i < tokens.size(); i++)
+            for (int i = 0; i < width; i++)
             {
-                if (std::find(skip_indices.begin(), skip_indices.end(), i) != skip_indices.end())
+                if (i == target)
                     continue;
 
+                // Missing cells say nothing about the class, so they are
+                // skipped, as in score_discrete()
                 if (std::find(nums.begin(), nums.end(), i) != nums.end())
                 {
                     // It's a num
-                    log_likelihood += std::log(pair.second.get_column_likelihood(i, std::stod(tokens[i])));
+                    double val = row.get_num(i);
+                    if (val == val)
+                        log_likelihood += std::log(table.get_column_likelihood(i, val));
                 }
-                else
+                else if (!token_missing(tokens[i]))
                 {
                     // It's a sym
-                    log_likelihood += std::log(pair.second.get_column_likelihood(i, tokens[i]));
+                    log_likelihood += std::log(table.get_column_likelihood(i, tokens[i]));
                 }
             }
-            //std::cout << "(log_likelihood=" << log_likelihood << ") ";
 
-            double log_posterior = std::log(prior) + log_likelihood;
-            if (log_posterior > highest_log_posterior)
+            scores.top.push_back({id, &class_names[id], std::log(prior) + log_likelihood, 0});
+        }
+        return !scores.top.empty();
+    }
+
+    /**
+     * Turns the log posteriors in scores.top into probabilities with the
+     * log-sum-exp trick: subtracting the largest before exponentiating
+     * keeps the sum from underflowing however many columns there are.
+     * Then moves the k most likely classes to the front, best first, and
+     * drops the rest.
+     */
+    static void rank(Scores &scores, size_t k)
+    {
+        std::vector<Scores::Class> &top = scores.top;
+        const double inf = std::numeric_limits<double>::infinity();
+
+        // A NaN (e.g. a zero sd) rules a class out, like a zero likelihood
+        double highest = -inf;
+        for (Scores::Class &c : top)
+        {
+            if (c.log_posterior != c.log_posterior)
+                c.log_posterior = -inf;
+            highest = std::max(highest, c.log_posterior);
+        }
+
+        // If every class is impossible, none is more likely than another
+        double sum = 0;
+        for (Scores::Class &c : top)
+        {
+            c.probability = highest == -inf ? 1 : std::exp(c.log_posterior - highest);
+            sum += c.probability;
+        }
+        for (Scores::Class &c : top)
+            c.probability /= sum;
+
+        // Ties go to the class whose name sorts first
+        if (k == 0 || k > top.size())
+            k = top.size();
+        std::partial_sort(top.begin(), top.begin() + k, top.end(),
+                          [](const Scores::Class &a, const Scores::Class &b) {
+                              if (a.log_posterior != b.log_posterior)
+                                  return a.log_posterior > b.log_posterior;
+                              return *a.label < *b.label;
+                          });
+
+        scores.margin = top.size() > 1 ? top[0].probability - top[1].probability : 1;
+        top.resize(k);
+    }
+
+public:
+    /**
+     * @param m - How to score numeric columns
+     * @param k - Laplace smoothing of the DISCRETIZED counts
+     * @param warmup - Rows seen before DISCRETIZED first bins the numbers;
+     *                 the bins are refit whenever the rows double after that
+     * @param cohen, size, trivial - Passed to Divide when binning
+     */
+    NaiveBayes(Mode m = GAUSSIAN, double k = 1, size_t warmup = 20,
+               double cohen = 0.3, double size = 0.5, double trivial = 1.025)
+        : mode(m), next_fit(warmup), k(k), cohen(cohen), size(size), trivial(trivial)
+    {
+    }
+
+    void add_header(std::string line) override
+    {
+        // We'll deal with the individual tables later.
+        master_table.add_header(line);
+        nums = master_table.get_nums();
+        syms = master_table.get_syms();
+        header_line = line;
+
+        std::vector<int> goals = master_table.get_goals();
+        target = goals.empty() ? -1 : goals[goals.size() - 1];
+
+        if (mode != DISCRETIZED)
+            return;
+
+        // Every column except the class is a feature; rows have already
+        // lost their skipped columns
+        int columns = nums.size() + syms.size();
+
+        for (int i = 0; i < columns; i++)
+        {
+            if (i == target)
+                continue;
+
+            features.push_back(i);
+            is_num.push_back(std::find(nums.begin(), nums.end(), i) != nums.end());
+        }
+
+        cuts.resize(features.size());
+        symbols.resize(features.size());
+        raw.resize(features.size());
+    }
+
+    /**
+     * Estimated bytes held by each part of the model: the class names and
+     * ids ("classes"), the per-class tables of GAUSSIAN mode
+     * ("class_tables"), the table of every row seen
+     * ("master_table"), the DISCRETIZED counts, bins and training values
+     * ("counts"), and the log tables ("logs").
+     */
+    std::map<std::string, size_t> memory_breakdown() const
+    {
+        std::map<std::string, size_t> parts;
+        parts["classes"] = Memory::heap(class_ids) + Memory::heap(class_names);
+        parts["class_tables"] = Memory::heap(class_tables);
+        parts["master_table"] = Memory::heap(master_table);
+        parts["counts"] = Memory::heap(features) + Memory::heap(is_num) + Memory::heap(cuts) +
+                          Memory::heap(symbols) + Memory::heap(raw) + Memory::heap(row_classes) +
+                          Memory::heap(class_counts);
+        parts["logs"] = Memory::heap(log_ints) + Memory::heap(log_counts);
+        return parts;
+    }
+
+    // Estimated bytes used by the model, including everything it holds
+    size_t memory_usage() const
+    {
+        size_t bytes = sizeof(NaiveBayes) + Memory::heap(header_line) +
+                       Memory::heap(nums) + Memory::heap(syms) + Memory::heap(query) +
+                       Memory::block(scratch.top.capacity() * sizeof(Scores::Class));
+        for (const std::pair<const std::string, size_t> &part : memory_breakdown())
+            bytes += part.second;
+        return bytes;
+    }
+
+    void print_num_stats()
+    {
+        if (mode == DISCRETIZED)
+        {
+            for (size_t f = 0; f < features.size(); f++)
             {
-                highest_log_posterior = log_posterior;
-                most_likely_class = pair.first;
+                if (!is_num[f])
+                    continue;
+
+                std::cout << features[f] << ": ";
+                cuts[f].print();
             }
-            //std::cout << log_posterior << " ";
+            return;
+        }
+
+        for (const std::pair<const std::string, int> &pair : class_ids)
+        {
+            std::cout << pair.first << ":\n";
+            class_tables[pair.second].print_num_stats();
+            std::cout << "\n";
         }
-        //std::cout << "\n";
-        return most_likely_class;
+    }
+
+    using Learner::add_row;
+    using Learner::classify;
+
+    bool parse(std::string line, Row &row) const override
+    {
+        return master_table.parse(line, row);
+    }
+
+    void add_row(const Row &row) override
+    {
+        INSTRUMENT_SCOPE("NaiveBayes::add_row");
+        if (mode == DISCRETIZED)
+        {
+            add_discrete_row(row);
+            return;
+        }
+
+        const std::vector<std::string> &tokens = row.get_cells();
+        int id = intern(tokens[tokens.size() - 1]);
+
+        // If there's no table for the current class, create one.
+        if (static_cast<size_t>(id) == class_tables.size())
+        {
+            class_tables.emplace_back();
+            class_tables[id].add_header(header_line);
+        }
+
+        class_tables[id].add_row(row);
+        master_table.add_row(row);
+    }
+
+    // Number of classes seen; their ids are 0 to classes() - 1
+    size_t classes() const
+    {
+        return class_names.size();
+    }
+
+    const std::string &class_name(int id) const
+    {
+        return class_names[id];
+    }
+
+    /**
+     * Scores a row against every class in one pass.
+     *
+     * @param row - The row to classify
+     * @param scores - Where the k most likely classes go, best first, with
+     *                 their probabilities. Its storage is reused, so keeping
+     *                 one Scores across calls means they don't allocate.
+     * @param k - How many classes to keep; 0 keeps them all
+     * @return false if the row can't be scored (scores.top is then empty)
+     */
+    bool predict(const Row &row, Scores &scores, size_t k = 0)
+    {
+        INSTRUMENT_SCOPE("NaiveBayes::predict");
+        scores.top.clear();
+        scores.margin = 0;
+
+        if (row.get_cells().size() == 0)
+            return false;
+
+        bool scored = mode == DISCRETIZED ? score_discrete(row, scores) : score_gaussian(row, scores);
+        if (scored)
+            rank(scores, k);
+        return scored;
+    }
+
+    std::string classify(const Row &row) override
+    {
+        INSTRUMENT_SCOPE("NaiveBayes::classify");
+        if (row.get_cells().size() == 0)
+            return "null";
+
+        return predict(row, scratch, 1) ? *scratch.top[0].label : "";
     }
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,52 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <algorithm>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+/**
+ * Returns how many threads to use: the requested count, or one per core
+ * when 0 is requested.
+ */
+inline unsigned thread_count(unsigned requested = 0)
+{
+    if (requested > 0)
+        return requested;
+
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+/**
+ * Splits [0, n) into one contiguous chunk per thread and runs
+ * f(begin, end, thread) on each. Chunk boundaries depend only on n and
+ * threads, so callers can run several passes over the same chunks.
+ * The calling thread runs the last chunk itself.
+ *
+ * @param n - Number of items
+ * @param threads - Number of chunks (and threads); 0 means one per core
+ * @param f - Called as f(size_t begin, size_t end, unsigned thread)
+ */
+template <class F>
+void parallel_for(size_t n, unsigned threads, F f)
+{
+    threads = std::min<size_t>(thread_count(threads), std::max<size_t>(n, 1));
+
+    if (threads == 1)
+    {
+        f(size_t(0), n, 0u);
+        return;
+    }
+
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t + 1 < threads; t++)
+        workers.emplace_back(f, n * t / threads, n * (t + 1) / threads, t);
+
+    f(n * (threads - 1) / threads, n, threads - 1);
+
+    for (std::thread &worker : workers)
+        worker.join();
+}
+
+#endif
@@ -0,0 +1,178 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include "Tbl.h"
+#include "Abcd.h"
+#include "Learner.h"
+#include "Queue.h"
+#include <chrono>
+#include <istream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * Prequential (test, then train) evaluation of several learners in one
+ * pass over a CSV stream. One thread reads and parses every line once;
+ * each learner runs on its own thread, fed through its own bounded
+ * lock-free queue, and keeps its own Abcd. The first rows only train, like
+ * the warm-up in hw/4's driver.
+ *
+ * Rows travel in batches shared by all the learners, so the queues move
+ * one pointer per batch rather than one per row. Lines with missing or
+ * extra cells are dropped before they reach any learner.
+ */
+class Pipeline
+{
+public:
+    struct Result
+    {
+        std::string name;
+        size_t rows = 0;
+        double seconds = 0; // time spent in the learner
+        Abcd<std::string> abcd;
+    };
+
+private:
+    typedef std::shared_ptr<const std::vector<Row>> Batch;
+
+    struct Stage
+    {
+        std::unique_ptr<Learner> learner;
+        Queue<Batch> queue;
+        Result result;
+
+        Stage(size_t capacity) : queue(capacity) {}
+    };
+
+    std::vector<std::unique_ptr<Stage>> stages;
+    size_t batch_size;
+    size_t capacity;
+    size_t rejected = 0;
+
+    static void learn(Stage &stage, int target, size_t warmup)
+    {
+        Result &result = stage.result;
+        Learner &learner = *stage.learner;
+
+        // An empty batch marks the end of the stream
+        for (Batch batch = stage.queue.pop(); batch; batch = stage.queue.pop())
+        {
+            auto start = std::chrono::steady_clock::now();
+            for (const Row &row : *batch)
+            {
+                if (result.rows++ >= warmup)
+                    result.abcd.add(row.get_cells()[target], learner.classify(row));
+                learner.add_row(row);
+            }
+            auto stop = std::chrono::steady_clock::now();
+            result.seconds += std::chrono::duration<double>(stop - start).count();
+        }
+    }
+
+public:
+    /**
+     * @param batch_size - Rows per batch handed to the learners
+     * @param capacity - Most batches waiting for each learner
+     */
+    Pipeline(size_t batch_size = 64, size_t capacity = 64)
+        : batch_size(std::max<size_t>(batch_size, 1)), capacity(capacity)
+    {
+    }
+
+    /**
+     * @param name - Name of the learner in the results
+     * @param learner - A fresh learner, with no header yet
+     */
+    void add(const std::string &name, std::unique_ptr<Learner> learner)
+    {
+        stages.emplace_back(new Stage(capacity));
+        stages.back()->learner = std::move(learner);
+        stages.back()->result.name = name;
+    }
+
+    // Lines of the last run() that had missing or extra cells
+    size_t get_rejected() const
+    {
+        return rejected;
+    }
+
+    /**
+     * Runs every learner over a CSV stream: header first, then rows. The
+     * class is the last goal.
+     *
+     * @param warmup - Number of rows that only train
+     * @return One result per learner, in the order they were added
+     */
+    std::vector<Result> run(std::istream &in, size_t warmup = 20)
+    {
+        std::vector<Result> results;
+        rejected = 0;
+
+        // Read header line, skipping empty/whitespace lines and comments
+        std::string line;
+        while (std::getline(in, line))
+        {
+            std::string text = line.substr(0, line.find('#'));
+            if (text.find_first_not_of(' ') != std::string::npos)
+                break;
+        }
+
+        Tbl schema;
+        schema.add_header(line);
+        std::vector<int> goals = schema.get_goals();
+        if (goals.size() == 0)
+            throw "Error: No goals\n";
+        int target = goals[goals.size() - 1];
+
+        std::vector<std::thread> workers;
+        for (std::unique_ptr<Stage> &stage : stages)
+        {
+            stage->learner->add_header(line);
+            workers.emplace_back(learn, std::ref(*stage), target, warmup);
+        }
+
+        // Parse every line once, and hand each batch to every learner.
+        // parse() checks each line against the header's width, so short
+        // rows never reach the learners' row.get_cells()[target].
+        std::vector<Row> rows;
+        Row row;
+        while (std::getline(in, line))
+        {
+            if (!schema.parse(line, row))
+            {
+                std::string text = line.substr(0, line.find('#'));
+                rejected += text.find_first_not_of(' ') != std::string::npos;
+                continue;
+            }
+
+            rows.push_back(std::move(row));
+            if (rows.size() == batch_size)
+            {
+                Batch batch = std::make_shared<const std::vector<Row>>(std::move(rows));
+                for (std::unique_ptr<Stage> &stage : stages)
+                    stage->queue.push(batch);
+                rows.clear();
+            }
+        }
+
+        if (!rows.empty())
+        {
+            Batch batch = std::make_shared<const std::vector<Row>>(std::move(rows));
+            for (std::unique_ptr<Stage> &stage : stages)
+                stage->queue.push(batch);
+        }
+
+        for (std::unique_ptr<Stage> &stage : stages)
+            stage->queue.push(Batch());
+        for (std::thread &worker : workers)
+            worker.join();
+
+        for (std::unique_ptr<Stage> &stage : stages)
+            results.push_back(stage->result);
+        return results;
+    }
+};
+
+#endif
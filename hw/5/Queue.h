@@ -0,0 +1,77 @@
+#ifndef QUEUE_H
+#define QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <utility>
+#include <vector>
+
+/**
+ * Bounded lock-free queue between exactly one producer thread and one
+ * consumer thread: a ring buffer whose two ends are atomic counters, each
+ * written by one side only. push() and pop() spin (yielding) while the
+ * queue is full or empty.
+ */
+template <class T>
+class Queue
+{
+    std::vector<T> slots;
+    size_t mask;
+
+    // Kept on separate cache lines so the two threads don't fight over one
+    alignas(64) std::atomic<size_t> head{0}; // next slot to pop
+    alignas(64) std::atomic<size_t> tail{0}; // next slot to push
+
+public:
+    /**
+     * @param capacity - Most items in the queue; rounded up to a power of two
+     */
+    Queue(size_t capacity = 1024)
+    {
+        size_t size = 1;
+        while (size < capacity)
+            size *= 2;
+
+        slots.resize(size);
+        mask = size - 1;
+    }
+
+    bool try_push(T &item)
+    {
+        size_t t = tail.load(std::memory_order_relaxed);
+        if (t - head.load(std::memory_order_acquire) == slots.size())
+            return false;
+
+        slots[t & mask] = std::move(item);
+        tail.store(t + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool try_pop(T &item)
+    {
+        size_t h = head.load(std::memory_order_relaxed);
+        if (h == tail.load(std::memory_order_acquire))
+            return false;
+
+        item = std::move(slots[h & mask]);
+        head.store(h + 1, std::memory_order_release);
+        return true;
+    }
+
+    void push(T item)
+    {
+        while (!try_push(item))
+            std::this_thread::yield();
+    }
+
+    T pop()
+    {
+        T item;
+        while (!try_pop(item))
+            std::this_thread::yield();
+        return item;
+    }
+};
+
+#endif
@@ -1,17 +1,54 @@
 #ifndef ROW_H
 #define ROW_H
 
+#include "Memory.h"
 #include <vector>
+#include <string>
 #include <iostream>
+#include <utility>
 
 class Row
 {
     std::vector<std::string> cells;
     std::vector<std::string> cooked;
+    std::vector<double> nums; // parsed Num cells; NaN for Syms and missing cells
     int dom = 0;
 
 public:
-    Row(std::vector<std::string> v) : cells(v) {}
+    Row() = default;
+
+    Row(std::vector<std::string> v) : cells(std::move(v)) {}
+
+    Row(std::vector<std::string> v, std::vector<double> n) : cells(std::move(v)), nums(std::move(n)) {}
+
+    const std::vector<std::string> &get_cells() const
+    {
+        return cells;
+    }
+
+    // The parsed value of cell i; see Tbl::parse()
+    double get_num(int i) const
+    {
+        return nums[i];
+    }
+
+    // Bytes used by this row, including its cells
+    size_t memory_usage() const
+    {
+        return sizeof(Row) + Memory::heap(cells) + Memory::heap(cooked) + Memory::heap(nums);
+    }
+
+    // Number of rows this one dominates; see Tbl::dom()
+    int get_dom() const
+    {
+        return dom;
+    }
+
+    void set_dom(int d)
+    {
+        dom = d;
+    }
+
     void print()
     {
         std::cout << "|  |  cells\n";
@@ -0,0 +1,313 @@
+#ifndef SCOTT_KNOTT_H
+#define SCOTT_KNOTT_H
+
+#include "Parallel.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * Scott-Knott ranking of treatments, e.g. the per-fold scores of several
+ * learners. Treatments are sorted by median; a list of them is split where
+ * the expected squared difference between the means of the two sides is
+ * largest, and the split is kept (and both sides split again) only when
+ * the two sides differ by a bootstrap test and by more than a small
+ * Cliff's delta. Treatments that end up in the same list share a rank;
+ * ranks go up from the lowest medians.
+ *
+ * The bootstrap draws its resamples from a counter-based hash instead of
+ * a sequential generator, so any resample can be drawn on any thread and
+ * the answer doesn't depend on how many threads there are. Each resample
+ * first fills a buffer of indices in a branch-free integer loop (which the
+ * compiler vectorizes) and then sums the picked values in four lanes.
+ */
+class ScottKnott
+{
+public:
+    struct Result
+    {
+        std::string name;
+        int rank;
+        double median, iqr;
+        std::vector<double> scores; // sorted
+    };
+
+private:
+    std::vector<Result> treatments;
+    double conf;
+    int b;
+    double small;
+    unsigned threads;
+    uint32_t seed;
+
+    struct Stats
+    {
+        double n = 0, sum = 0, sumsq = 0;
+
+        double mean() const
+        {
+            return n ? sum / n : 0;
+        }
+
+        double var() const
+        {
+            return n > 1 ? std::max(0.0, (sumsq - sum * sum / n) / (n - 1)) : 0;
+        }
+    };
+
+    static Stats stats(const double *vals, size_t n)
+    {
+        Stats s;
+        s.n = n;
+        for (size_t i = 0; i < n; i++)
+        {
+            s.sum += vals[i];
+            s.sumsq += vals[i] * vals[i];
+        }
+        return s;
+    }
+
+    // Difference of means over its standard error
+    static double delta(const Stats &y, const Stats &z)
+    {
+        double d = std::abs(y.mean() - z.mean());
+        double se = std::sqrt(y.var() / y.n + z.var() / z.n);
+        return se > 0 ? d / se : d;
+    }
+
+    // 32-bit integer hash (from Chris Wellons' hash prospector)
+    static uint32_t mix(uint32_t x)
+    {
+        x ^= x >> 16;
+        x *= 0x7feb352d;
+        x ^= x >> 15;
+        x *= 0x846ca68b;
+        x ^= x >> 16;
+        return x;
+    }
+
+    // Stats of the stream'th resample (with replacement) of vals
+    static Stats resample(const std::vector<double> &vals, uint32_t stream, std::vector<uint32_t> &idx)
+    {
+        size_t n = vals.size();
+        idx.resize(n);
+
+        uint32_t key = mix(stream);
+        uint64_t range = n;
+        for (size_t j = 0; j < n; j++)
+            idx[j] = static_cast<uint32_t>((uint64_t(mix(uint32_t(j) * 0x9e3779b9u + key)) * range) >> 32);
+
+        double sum[4] = {0, 0, 0, 0}, sumsq[4] = {0, 0, 0, 0};
+        size_t j = 0;
+        for (; j + 4 <= n; j += 4)
+        {
+            for (int k = 0; k < 4; k++)
+            {
+                double x = vals[idx[j + k]];
+                sum[k] += x;
+                sumsq[k] += x * x;
+            }
+        }
+        for (; j < n; j++)
+        {
+            sum[0] += vals[idx[j]];
+            sumsq[0] += vals[idx[j]] * vals[idx[j]];
+        }
+
+        Stats s;
+        s.n = n;
+        s.sum = (sum[0] + sum[1]) + (sum[2] + sum[3]);
+        s.sumsq = (sumsq[0] + sumsq[1]) + (sumsq[2] + sumsq[3]);
+        return s;
+    }
+
+    // The p'th percentile of a sorted list, 0 <= p <= 1
+    static double percentile(const std::vector<double> &sorted, double p)
+    {
+        if (sorted.empty())
+            return 0;
+        return sorted[std::min<size_t>(p * sorted.size(), sorted.size() - 1)];
+    }
+
+    // Pools the scores of treatments [low, high), sorted
+    std::vector<double> pool(size_t low, size_t high) const
+    {
+        std::vector<double> all;
+        for (size_t i = low; i < high; i++)
+            all.insert(all.end(), treatments[i].scores.begin(), treatments[i].scores.end());
+        std::sort(all.begin(), all.end());
+        return all;
+    }
+
+    int divide(size_t low, size_t high, int rank)
+    {
+        // Find the cut with the largest expected squared difference of means
+        Stats all;
+        for (size_t i = low; i < high; i++)
+        {
+            Stats s = stats(treatments[i].scores.data(), treatments[i].scores.size());
+            all.n += s.n, all.sum += s.sum, all.sumsq += s.sumsq;
+        }
+
+        double mu = all.mean(), best = 0;
+        size_t cut = 0;
+        Stats left;
+        for (size_t i = low; i + 1 < high; i++)
+        {
+            Stats s = stats(treatments[i].scores.data(), treatments[i].scores.size());
+            left.n += s.n, left.sum += s.sum, left.sumsq += s.sumsq;
+
+            Stats right;
+            right.n = all.n - left.n;
+            right.sum = all.sum - left.sum;
+
+            double now = left.n / all.n * std::pow(left.mean() - mu, 2) +
+                         right.n / all.n * std::pow(right.mean() - mu, 2);
+            if (now > best)
+            {
+                best = now;
+                cut = i + 1;
+            }
+        }
+
+        if (cut > 0)
+        {
+            std::vector<double> l = pool(low, cut), r = pool(cut, high);
+            if (std::abs(cliffs_delta(l, r)) > small && different(l, r))
+            {
+                rank = divide(low, cut, rank) + 1;
+                return divide(cut, high, rank);
+            }
+        }
+
+        for (size_t i = low; i < high; i++)
+            treatments[i].rank = rank;
+        return rank;
+    }
+
+public:
+    /**
+     * @param conf - Significance level of the bootstrap test
+     * @param b - Number of bootstrap resamples
+     * @param small - Largest Cliff's delta that counts as a small effect
+     * @param threads - Number of threads for the bootstrap; 0 means one per core
+     * @param seed - Seed for the resamples
+     */
+    ScottKnott(double conf = 0.05, int b = 1000, double small = 0.147, unsigned threads = 0, unsigned seed = 1)
+        : conf(conf), b(b), small(small), threads(threads), seed(seed)
+    {
+    }
+
+    /**
+     * @param name - Name of the treatment
+     * @param scores - Its results, e.g. one per cross-validation fold
+     */
+    void add(const std::string &name, const std::vector<double> &scores)
+    {
+        Result r;
+        r.name = name;
+        r.rank = 0;
+        r.scores = scores;
+        std::sort(r.scores.begin(), r.scores.end());
+        r.median = percentile(r.scores, 0.5);
+        r.iqr = percentile(r.scores, 0.75) - percentile(r.scores, 0.25);
+        treatments.push_back(r);
+    }
+
+    /**
+     * Cliff's delta of two sorted lists: the fraction of pairs where the
+     * first list is bigger, minus the fraction where it is smaller. One
+     * merge-like pass instead of comparing every pair.
+     */
+    static double cliffs_delta(const std::vector<double> &a, const std::vector<double> &b)
+    {
+        if (a.empty() || b.empty())
+            return 0;
+
+        double gt = 0, lt = 0;
+        size_t below = 0, upto = 0; // how many of b are < x, and <= x
+        for (double x : a)
+        {
+            while (below < b.size() && b[below] < x)
+                below++;
+            while (upto < b.size() && b[upto] <= x)
+                upto++;
+
+            gt += below;
+            lt += b.size() - upto;
+        }
+
+        return (gt - lt) / (static_cast<double>(a.size()) * b.size());
+    }
+
+    /**
+     * Bootstrap test of whether two samples have different means (Efron
+     * and Tibshirani, p221): shift both samples to the pooled mean, and
+     * see how often resamples of the shifted samples differ more than the
+     * originals did.
+     */
+    bool different(const std::vector<double> &y0, const std::vector<double> &z0) const
+    {
+        if (y0.empty() || z0.empty())
+            return false;
+
+        Stats y = stats(y0.data(), y0.size()), z = stats(z0.data(), z0.size());
+        double observed = delta(y, z);
+        double mu = (y.sum + z.sum) / (y.n + z.n);
+
+        std::vector<double> yhat(y0), zhat(z0);
+        for (double &val : yhat)
+            val += mu - y.mean();
+        for (double &val : zhat)
+            val += mu - z.mean();
+
+        unsigned t = thread_count(threads);
+        std::vector<size_t> bigger(t, 0);
+        parallel_for(b, t, [&](size_t begin, size_t end, unsigned thread) {
+            std::vector<uint32_t> idx;
+            size_t count = 0;
+            for (size_t i = begin; i < end; i++)
+            {
+                uint32_t stream = seed + 2 * static_cast<uint32_t>(i);
+                count += delta(resample(yhat, stream, idx), resample(zhat, stream + 1, idx)) > observed;
+            }
+            bigger[thread] = count;
+        });
+
+        size_t total = 0;
+        for (size_t count : bigger)
+            total += count;
+        return static_cast<double>(total) / b < conf;
+    }
+
+    /**
+     * Ranks the treatments added so far.
+     *
+     * @return The treatments, sorted by median, with their ranks
+     */
+    const std::vector<Result> &rank()
+    {
+        std::stable_sort(treatments.begin(), treatments.end(),
+                         [](const Result &x, const Result &y) { return x.median < y.median; });
+
+        if (!treatments.empty())
+            divide(0, treatments.size(), 1);
+        return treatments;
+    }
+
+    void report()
+    {
+        rank();
+
+        std::printf(" %4s | %15s | %8s | %8s\n", "rank", "rx", "median", "iqr");
+        std::printf(" %4s | %15s | %8s | %8s\n", "----", "----", "----", "----");
+        for (const Result &r : treatments)
+            std::printf(" %4d | %15s | %8.4f | %8.4f\n", r.rank, r.name.c_str(), r.median, r.iqr);
+    }
+};
+
+#endif
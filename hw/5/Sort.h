@@ -0,0 +1,162 @@
+#ifndef SORT_H
+#define SORT_H
+
+#include "Parallel.h"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <numeric>
+#include <vector>
+
+/**
+ * Argsort routines: each returns the permutation of indices that puts the
+ * values in ascending order, leaving the values themselves in place.
+ *
+ * Doubles go through an LSD radix sort on their IEEE-754 bit patterns,
+ * flipped so that unsigned order matches numeric order (-0 sorts just
+ * before +0, and NaNs end up at the extremes by sign). The sort is stable.
+ */
+class Sort
+{
+    // 11-bit digits: six passes, and a 2048-entry histogram still fits in L1
+    static constexpr int BITS = 11;
+    static constexpr int BUCKETS = 1 << BITS;
+    static constexpr int PASSES = (64 + BITS - 1) / BITS;
+
+    // Maps a double to an unsigned key with the same ordering
+    static uint64_t key(double val)
+    {
+        uint64_t bits;
+        std::memcpy(&bits, &val, sizeof bits);
+
+        const uint64_t sign = 1ull << 63;
+        return (bits & sign) ? ~bits : bits | sign;
+    }
+
+    static int digit(uint64_t key, int pass)
+    {
+        return (key >> (pass * BITS)) & (BUCKETS - 1);
+    }
+
+public:
+    // Returns true if the values are already in ascending order
+    template <class T>
+    static bool is_sorted(const std::vector<T> &vals)
+    {
+        return std::is_sorted(vals.begin(), vals.end());
+    }
+
+    /**
+     * Stable argsort by comparison, for any type with operator<.
+     */
+    template <class T>
+    static std::vector<uint32_t> argsort(const std::vector<T> &vals)
+    {
+        std::vector<uint32_t> idx(vals.size());
+        std::iota(idx.begin(), idx.end(), 0);
+
+        if (is_sorted(vals))
+            return idx;
+
+        std::stable_sort(idx.begin(), idx.end(),
+                         [&](uint32_t a, uint32_t b) { return vals[a] < vals[b]; });
+        return idx;
+    }
+
+    /**
+     * Radix argsort of doubles.
+     *
+     * @param vals - The values; fewer than 2^32 of them
+     * @param threads - Number of threads; 0 means one per core
+     */
+    static std::vector<uint32_t> argsort(const std::vector<double> &vals, unsigned threads = 1)
+    {
+        size_t n = vals.size();
+        std::vector<uint32_t> idx(n);
+        std::iota(idx.begin(), idx.end(), 0);
+
+        if (is_sorted(vals))
+            return idx;
+
+        threads = std::min<size_t>(thread_count(threads), std::max<size_t>(n / 65536, 1));
+
+        std::vector<uint64_t> keys(n), keys_tmp(n);
+        std::vector<uint32_t> idx_tmp(n);
+
+        // Histograms of every pass, filled in a single read of the keys.
+        // Their totals don't depend on the order of the keys.
+        std::vector<size_t> totals(PASSES * BUCKETS, 0);
+        std::vector<std::vector<size_t>> partials(threads, std::vector<size_t>(PASSES * BUCKETS, 0));
+        parallel_for(n, threads, [&](size_t begin, size_t end, unsigned t) {
+            size_t *count = partials[t].data();
+            for (size_t i = begin; i < end; i++)
+            {
+                uint64_t k = key(vals[i]);
+                keys[i] = k;
+                for (int pass = 0; pass < PASSES; pass++)
+                    ++count[pass * BUCKETS + digit(k, pass)];
+            }
+        });
+        for (const std::vector<size_t> &partial : partials)
+            for (size_t b = 0; b < totals.size(); b++)
+                totals[b] += partial[b];
+
+        std::vector<size_t> counts(threads * BUCKETS), offsets(threads * BUCKETS);
+        for (int pass = 0; pass < PASSES; pass++)
+        {
+            // Skip passes where every key has the same digit
+            if (totals[pass * BUCKETS + digit(keys[0], pass)] == n)
+                continue;
+
+            // Each thread scatters its own chunk, so it needs the digit
+            // counts of that chunk in the keys' current order
+            if (threads == 1)
+                std::copy_n(&totals[pass * BUCKETS], BUCKETS, counts.begin());
+            else
+            {
+                std::fill(counts.begin(), counts.end(), 0);
+                parallel_for(n, threads, [&](size_t begin, size_t end, unsigned t) {
+                    size_t *count = &counts[t * BUCKETS];
+                    for (size_t i = begin; i < end; i++)
+                        ++count[digit(keys[i], pass)];
+                });
+            }
+
+            // Turn counts into write offsets, bucket-major then thread-major,
+            // so each thread's chunk lands in order and the sort stays stable
+            size_t sum = 0;
+            for (int b = 0; b < BUCKETS; b++)
+                for (unsigned t = 0; t < threads; t++)
+                {
+                    offsets[t * BUCKETS + b] = sum;
+                    sum += counts[t * BUCKETS + b];
+                }
+
+            parallel_for(n, threads, [&](size_t begin, size_t end, unsigned t) {
+                // Local copies, so the compiler knows the stores below
+                // can't alias the offsets or the source arrays
+                size_t offset[BUCKETS];
+                std::copy_n(&offsets[t * BUCKETS], BUCKETS, offset);
+                const uint64_t *src_keys = keys.data();
+                const uint32_t *src_idx = idx.data();
+                uint64_t *dst_keys = keys_tmp.data();
+                uint32_t *dst_idx = idx_tmp.data();
+
+                for (size_t i = begin; i < end; i++)
+                {
+                    uint64_t k = src_keys[i];
+                    size_t pos = offset[digit(k, pass)]++;
+                    dst_keys[pos] = k;
+                    dst_idx[pos] = src_idx[i];
+                }
+            });
+
+            keys.swap(keys_tmp);
+            idx.swap(idx_tmp);
+        }
+
+        return idx;
+    }
+};
+
+#endif
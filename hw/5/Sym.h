@@ -10,7 +10,7 @@
 #include <vector>
 
 template <typename T = std::string>
-class Sym : public Col
+class Sym final : public Col
 {
     T mode;
     int most;
@@ -35,7 +35,7 @@ public:
     }
 
     // Adds a char. Uses code from https://stackoverflow.com/a/9371137
-    void operator+=(std::string val) override
+    void add(const T &val)
     {
         ++n;
         ++counts[val];
@@ -47,13 +47,7 @@ public:
         most = pair.second;
     }
 
-    bool isGreater(Col& other, double epsilon) override
-    {
-        Sym<>& col = dynamic_cast<Sym<>&>(other);
-        return (this->get_mode() != col.get_mode());
-    }
-
-    void operator-=(std::string val) override
+    void remove(const T &val)
     {
         --n;
         --counts[val];
@@ -65,12 +59,42 @@ public:
         most = pair.second;
     }
 
-    double get_likelihood(std::string val)
+    void operator+=(std::string val) override
+    {
+        add(val);
+    }
+
+    void operator-=(std::string val) override
+    {
+        remove(val);
+    }
+
+    bool isGreater(Sym &col, double)
     {
-        return static_cast<double>(counts[val] + 1) / (n + counts.size());
+        return (this->get_mode() != col.get_mode());
+    }
+
+    bool isGreater(Col& other, double epsilon) override
+    {
+        return isGreater(dynamic_cast<Sym&>(other), epsilon);
     }
 
-    double SymEnt()
+    // Forgets all symbols, keeping the column's name and number
+    void reset()
+    {
+        n = 0;
+        counts.clear();
+    }
+
+    // Laplace-smoothed frequency of a symbol; unseen symbols count 0
+    double get_likelihood(const T &val) const
+    {
+        typename std::map<T, size_t>::const_iterator it = counts.find(val);
+        size_t count = it == counts.end() ? 0 : it->second;
+        return static_cast<double>(count + 1) / (n + counts.size());
+    }
+
+    double SymEnt() const
     {
         if (n == 0)
         {
@@ -95,11 +119,16 @@ public:
         return entropy;
     }
 
-    double variety() override
+    double variety() const override
     {
         return SymEnt();
     }
 
+    size_t memory_usage() const override
+    {
+        return sizeof(Sym) + Memory::heap(text) + Memory::heap(mode) + Memory::heap(counts);
+    }
+
     void print() override
     {
         std::cout << "|  |  cnt\n";
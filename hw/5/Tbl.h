@@ -6,7 +6,13 @@
 #include "Col.h"
 #include "Num.h"
 #include "Sym.h"
+#include "Parallel.h"
+#include "Instrument.h"
+#include "Memory.h"
 #include <algorithm>
+#include <cmath>
+#include <limits>
+#include <random>
 #include <fstream>
 #include <numeric>
 #include <sstream>
@@ -17,17 +23,21 @@
 class Tbl
 {
     std::vector<Row> rows;
-    // from https://stackoverflow.com/a/8777747
-    std::vector<std::shared_ptr<Col>> cols;
 
-    std::vector<std::vector<std::string>> table;
+    // Column summaries by kind, held by value so the hot paths call them
+    // directly. slots[i] says whether column i is a Num and where it is in
+    // num_cols or sym_cols.
+    std::vector<Num> num_cols;
+    std::vector<Sym<>> sym_cols;
+    std::vector<std::pair<bool, int>> slots;
+
     std::vector<std::string> headers;
     std::vector<int> skip_indices;
 
     std::vector<int> goals, xs, nums, syms, w;
 
     // Helper functions
-    void remove_comments(std::string &line)
+    void remove_comments(std::string &line) const
     {
         // Ignore comments
         size_t comment_pos;
@@ -52,38 +62,134 @@ class Tbl
         return false;
     }
 
-    std::vector<std::string> tokenize_line(const std::string &line)
+    static bool is_separator(char c)
     {
+        return c == ',' || c == ' ';
+    }
+
+    /**
+     * Splits a line into its cells, like tokenize_header(): the cells are
+     * the runs of characters between commas and spaces. The cells are
+     * counted first, so the vector is allocated once, at its final size.
+     */
+    std::vector<std::string> tokenize_line(const std::string &line) const
+    {
+        INSTRUMENT_SCOPE("Tbl::tokenize");
+        size_t count = 0;
+        for (size_t i = 0; i < line.size(); i++)
+            count += !is_separator(line[i]) && (i == 0 || is_separator(line[i - 1]));
+
         std::vector<std::string> values;
-        boost::char_separator<char> sep(", ");
-        boost::tokenizer<boost::char_separator<char>> tok(line, sep);
+        values.reserve(count);
 
         // Read all tokens in the line, but discard commas and spacing
-        for (auto it = tok.begin(); it != tok.end(); it++)
+        size_t i = 0;
+        while (i < line.size())
         {
-            std::string val;
-
-            // If ?, we replace it with 0 for now
-            if (*it == "?")
-                val = "";
-            else
-                val = *it;
-            values.push_back(val);
+            while (i < line.size() && is_separator(line[i]))
+                i++;
+
+            size_t start = i;
+            while (i < line.size() && !is_separator(line[i]))
+                i++;
+
+            // If ?, we replace it with an empty (missing) cell
+            if (i - start == 1 && line[start] == '?')
+                values.emplace_back();
+            else if (i > start)
+                values.emplace_back(line, start, i - start);
         }
 
         return values;
     }
 
+    // Makes a row from its cells, parsing the Num cells once
+    Row make_row(std::vector<std::string> cells) const
+    {
+        INSTRUMENT_SCOPE("Tbl::make_row");
+        std::vector<double> vals(cells.size(), std::numeric_limits<double>::quiet_NaN());
+        for (int idx : nums)
+            if (static_cast<size_t>(idx) < cells.size())
+                vals[idx] = Num::parse(cells[idx]);
+
+        return Row(std::move(cells), std::move(vals));
+    }
+
+    // Adds a column summary, numbered by its position in the table
+    void add_col(const std::string &name, bool num)
+    {
+        unsigned int id = slots.size() + 1;
+        if (num)
+        {
+            slots.emplace_back(true, num_cols.size());
+            num_cols.emplace_back(name);
+            num_cols.back().set_id(id);
+        }
+        else
+        {
+            slots.emplace_back(false, sym_cols.size());
+            sym_cols.emplace_back(name);
+            sym_cols.back().set_id(id);
+        }
+    }
+
+    Num &num_col(int idx)
+    {
+        return num_cols[slots[idx].second];
+    }
+
+    const Num &num_col(int idx) const
+    {
+        return num_cols[slots[idx].second];
+    }
+
+    Sym<> &sym_col(int idx)
+    {
+        return sym_cols[slots[idx].second];
+    }
+
+    const Sym<> &sym_col(int idx) const
+    {
+        return sym_cols[slots[idx].second];
+    }
+
+    // Adds a row's values to the column summaries. The row's cells are
+    // already free of skipped columns.
+    void add_values(const Row &row)
+    {
+        INSTRUMENT_SCOPE("Tbl::add_values");
+        const std::vector<std::string> &cells = row.get_cells();
+        for (int idx : nums)
+        {
+            if (static_cast<size_t>(idx) >= cells.size())
+                continue;
+
+            // Missing cells say nothing about the column
+            double val = row.get_num(idx);
+            if (val == val)
+                num_col(idx).add(val);
+        }
+
+        for (int idx : syms)
+        {
+            if (static_cast<size_t>(idx) >= cells.size())
+                continue;
+
+            sym_col(idx).add(cells[idx]);
+        }
+    }
+
 public:
-    Sym<> &get_classification_column() const
+    const Sym<> &get_classification_column() const
     {
         if (goals.size() == 0)
             throw "Error: No goals\n";
 
         // Assume the last goal is our target
         size_t col_index = goals[goals.size() - 1];
-        Sym<> &ptr = dynamic_cast<Sym<> &>(*cols[col_index].get());
-        return ptr;
+        if (slots[col_index].first)
+            throw "Error: The class is not a symbol\n";
+        return sym_col(col_index);
     }
 
     int size() const
@@ -91,6 +197,17 @@ public:
         return rows.size();
     }
 
+    const std::vector<Row> &get_rows() const
+    {
+        return rows;
+    }
+
+    // Column names, without the skipped columns
+    const std::vector<std::string> &get_headers() const
+    {
+        return headers;
+    }
+
     std::vector<int> get_skip_columns() const
     {
         return skip_indices;
@@ -106,19 +223,59 @@ public:
         return syms;
     }
 
+    std::vector<int> get_goals() const
+    {
+        return goals;
+    }
+
+    std::vector<int> get_xs() const
+    {
+        return xs;
+    }
+
+    /**
+     * Estimated bytes held by each part of the table: the rows and their
+     * cells ("rows"), the column summaries ("cols"), and the headers and
+     * column indices ("schema").
+     */
+    std::map<std::string, size_t> memory_breakdown() const
+    {
+        std::map<std::string, size_t> parts;
+        parts["rows"] = Memory::heap(rows);
+        parts["cols"] = Memory::heap(num_cols) + Memory::heap(sym_cols) + Memory::heap(slots);
+        parts["schema"] = Memory::heap(headers) + Memory::heap(skip_indices) + Memory::heap(goals) +
+                          Memory::heap(xs) + Memory::heap(nums) + Memory::heap(syms) + Memory::heap(w);
+        return parts;
+    }
+
+    // Estimated bytes used by the table, including everything it holds
+    size_t memory_usage() const
+    {
+        size_t bytes = sizeof(Tbl);
+        for (const std::pair<const std::string, size_t> &part : memory_breakdown())
+            bytes += part.second;
+        return bytes;
+    }
+
+    const Col &get_col(int idx) const
+    {
+        if (slots[idx].first)
+            return num_col(idx);
+        return sym_col(idx);
+    }
+
     double get_column_likelihood(int idx, double val) const
     {
-        Num& ptr = dynamic_cast<Num&>(*cols[idx].get());
-        double mu = ptr.get_mean();
-        double sd = std::sqrt(ptr.get_var());
+        const Num &num = num_col(idx);
+        double mu = num.get_mean();
+        double sd = std::sqrt(num.get_var());
 
         return std::exp(-std::pow(val - mu, 2) / (2 * sd * sd)) / (sd * std::sqrt(2 * 3.14159));
     }
 
     double get_column_likelihood(int idx, std::string val) const
     {
-        Sym<>& ptr = dynamic_cast<Sym<>&>(*cols[idx].get());  
-        return ptr.get_likelihood(val);
+        return sym_col(idx).get_likelihood(val);
     }
 
     void print_num_stats() const
@@ -126,20 +283,148 @@ public:
         std::cout << "[";
         for (int idx : nums)
         {
-            Num& ptr = dynamic_cast<Num&>(*cols[idx].get());
-            std::cout << ptr.get_mean() << ", ";
+            std::cout << num_col(idx).get_mean() << ", ";
         }
         std::cout << "]\n[";
         for (int idx : nums)
         {
-            Num& ptr = dynamic_cast<Num&>(*cols[idx].get());
-            std::cout << ptr.get_var() << ", ";
+            std::cout << num_col(idx).get_var() << ", ";
         }
         std::cout << "]";
     }
 
     /**
-     * Populates the headers, skip_indices, cols, nums, syms, goals, xs, and 
+     * Scores every row by continuous domination (Zitzler's indicator) over
+     * the numeric goals, normalized by each column's low and high. Columns
+     * in w are minimized, the others maximized. A row's dom is the number
+     * of rows it beats; sort_by_dom() then orders the table by it.
+     *
+     * Since the indicator only needs exp(w * (a - b) / n), and that is
+     * exp(w * a / n) / exp(w * b / n), the exponentials are taken once per
+     * cell and each comparison is just a few multiply-adds.
+     *
+     * @param samples - 0 compares every pair of rows, which is O(n^2);
+     *                  otherwise each row is compared against this many
+     *                  random rows
+     * @param threads - Number of threads; 0 means one per core
+     * @param seed - Seed for the sampled mode
+     */
+    void dom(int samples = 0, unsigned threads = 0, unsigned seed = 1)
+    {
+        std::vector<int> objectives;
+        for (int idx : goals)
+            if (std::find(nums.begin(), nums.end(), idx) != nums.end())
+                objectives.push_back(idx);
+
+        size_t n = rows.size();
+        size_t g = objectives.size();
+        if (n == 0 || g == 0)
+            return;
+
+        // ex[k][i] = exp(w * a / g) for goal k of row i, inv[k][i] = 1 / ex[k][i].
+        // Missing cells sit halfway between low and high.
+        std::vector<std::vector<double>> ex(g, std::vector<double>(n)), inv(g, std::vector<double>(n));
+        for (size_t k = 0; k < g; k++)
+        {
+            int c = objectives[k];
+            const Num &num = num_col(c);
+            double low = num.get_low(), range = num.get_high() - num.get_low();
+            double weight = std::find(w.begin(), w.end(), c) != w.end() ? -1 : 1;
+
+            for (size_t i = 0; i < n; i++)
+            {
+                double val = rows[i].get_num(c);
+                double norm = val != val ? 0.5 : (range > 0 ? (val - low) / range : 0);
+                ex[k][i] = std::exp(weight * norm / g);
+                inv[k][i] = 1 / ex[k][i];
+            }
+        }
+
+        // Row x beats row y when sum(ex[x] / ex[y]) > sum(ex[y] / ex[x])
+        auto beats = [&](size_t x, size_t y) {
+            double s1 = 0, s2 = 0;
+            for (size_t k = 0; k < g; k++)
+            {
+                s1 += ex[k][x] * inv[k][y];
+                s2 += ex[k][y] * inv[k][x];
+            }
+            return s1 > s2;
+        };
+
+        std::vector<int> scores(n, 0);
+
+        if (samples > 0)
+        {
+            parallel_for(n, threads, [&](size_t begin, size_t end, unsigned) {
+                std::mt19937 rng(seed + begin);
+                std::uniform_int_distribution<size_t> pick(0, n - 1);
+
+                for (size_t x = begin; x < end; x++)
+                    for (int s = 0; s < samples; s++)
+                        scores[x] += beats(x, pick(rng));
+            });
+        }
+        else
+        {
+            // Compare x against a block of ys at a time, goal by goal, so the
+            // inner loop runs over contiguous memory
+            const size_t BLOCK = 512;
+            parallel_for(n, threads, [&](size_t begin, size_t end, unsigned) {
+                std::vector<double> s1(BLOCK), s2(BLOCK);
+
+                for (size_t x = begin; x < end; x++)
+                {
+                    int wins = 0;
+                    for (size_t start = 0; start < n; start += BLOCK)
+                    {
+                        size_t len = std::min(BLOCK, n - start);
+                        std::fill(s1.begin(), s1.begin() + len, 0.0);
+                        std::fill(s2.begin(), s2.begin() + len, 0.0);
+
+                        for (size_t k = 0; k < g; k++)
+                        {
+                            const double ex_x = ex[k][x], inv_x = inv[k][x];
+                            const double *ex_y = &ex[k][start], *inv_y = &inv[k][start];
+                            for (size_t j = 0; j < len; j++)
+                            {
+                                s1[j] += ex_x * inv_y[j];
+                                s2[j] += ex_y[j] * inv_x;
+                            }
+                        }
+
+                        for (size_t j = 0; j < len; j++)
+                            wins += s1[j] > s2[j];
+                    }
+                    scores[x] = wins;
+                }
+            });
+        }
+
+        for (size_t i = 0; i < n; i++)
+            rows[i].set_dom(scores[i]);
+    }
+
+    /**
+     * Reorders the rows by dom, best first. Call dom()
+     * first. Ties keep their original order.
+     */
+    void sort_by_dom()
+    {
+        std::vector<size_t> order(rows.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(),
+                         [&](size_t a, size_t b) { return rows[a].get_dom() > rows[b].get_dom(); });
+
+        std::vector<Row> sorted_rows;
+        sorted_rows.reserve(rows.size());
+        for (size_t i : order)
+            sorted_rows.push_back(std::move(rows[i]));
+
+        rows.swap(sorted_rows);
+    }
+
+    /**
+     * Populates the headers, skip_indices, columns, nums, syms, goals, xs, and 
      * w member variables.
      */
     void add_header(std::string line)
@@ -166,6 +451,11 @@ public:
         // Copy the result to our private member variable
         skip_indices = q_pos;
 
+        // Rows lose the skipped cells in parse(), so the headers lose them
+        // too, and every column index counts only the kept columns
+        for (int index : q_pos)
+            headers.erase(std::next(headers.begin(), index));
+
         // Create columns
         for (int i = 0; i < headers.size(); i++)
         {
@@ -177,12 +467,12 @@ public:
                 x.find(">") != std::string::npos ||
                 x.find("$") != std::string::npos)
             {
-                cols.emplace_back(new Num(x));
+                add_col(x, true);
                 nums.push_back(i);
             }
             else
             {
-                cols.emplace_back(new Sym<>(x));
+                add_col(x, false);
                 syms.push_back(i);
             }
 
@@ -202,48 +492,74 @@ public:
     }
 
     /**
-     * Adds a row to the table. This is meant to be used by online
-     * classifiers. Make sure the add_header() function is called
-     * before this. Do not use this with read().
+     * Parses a CSV line into a row of this table: splits it, drops the
+     * skipped columns and converts the Num cells. Learners that share a
+     * header can parse a line once and all use the row. Make sure the
+     * add_header() function is called before this.
+     *
+     * @return false for blank lines and rows with missing or extra values
      */
-    void add_row(std::string line)
+    bool parse(std::string line, Row &row) const
     {
+        INSTRUMENT_SCOPE("Tbl::parse");
         remove_comments(line);
 
         // Check for blank lines
         if (line.empty() || line.find_first_not_of(' ') == std::string::npos)
-            return;
+            return false;
 
         std::vector<std::string> values = tokenize_line(line);
 
-        // Check that the row contained the right number of items
-        // Since classifiers using this function won't add a header, we
-        // need a different check.
-        if (table.size() != 0 && values.size() != table[0].size())
+        // Check that the row contained the right number of items: one
+        // per header, counting the skipped columns it still has
+        if (values.size() != headers.size() + skip_indices.size())
         {
             std::cerr << "Exception: Rows with missing or extra values, skipping.\n";
-            return;
+            INSTRUMENT_COUNT("Tbl::rejected", 1);
+            return false;
         }
 
-        // Remove the columns that we need to skip...
-        for (int index : skip_indices)
-            values.erase(std::next(values.begin(), index));
+        // Remove the columns that we need to skip
+        {
+            INSTRUMENT_SCOPE("Tbl::skip");
+            for (int index : skip_indices)
+                values.erase(std::next(values.begin(), index));
+        }
 
-        // ...then add the row to the table...
-        table.push_back(values);
+        row = make_row(std::move(values));
+        return true;
+    }
 
-        // ...and to the rows vector...
-        rows.push_back(Row(values));
+    /**
+     * Adds a parsed row (see parse()) to the table.
+     */
+    void add_row(const Row &row)
+    {
+        INSTRUMENT_SCOPE("Tbl::add_row");
+        INSTRUMENT_COUNT("Tbl::rows", 1);
+        rows.push_back(row);
+        add_values(rows.back());
+    }
 
-        // ...and finally to the cols vector
-        // Populate values
-        for (int i = 0; i < values.size(); i++)
-        {
-            if (std::find(skip_indices.begin(), skip_indices.end(), i) != skip_indices.end())
-                continue;
-            
-            *(cols[i]) += values[i];
-        }
+    // Adds a parsed row without copying it
+    void add_row(Row &&row)
+    {
+        INSTRUMENT_SCOPE("Tbl::add_row");
+        INSTRUMENT_COUNT("Tbl::rows", 1);
+        rows.push_back(std::move(row));
+        add_values(rows.back());
+    }
+
+    /**
+     * Adds a row to the table. This is meant to be used by online
+     * classifiers. Make sure the add_header() function is called
+     * before this. Do not use this with read().
+     */
+    void add_row(std::string line)
+    {
+        Row row;
+        if (parse(line, row))
+            add_row(std::move(row));
     }
 
     /**
@@ -253,6 +569,7 @@ public:
      */
     void read(std::string filename)
     {
+        INSTRUMENT_SCOPE("Tbl::read");
         // Open a file
         std::ifstream fin(filename);
         std::string line;
@@ -289,7 +606,9 @@ public:
             return;
         }
 
-        // Read other lines
+        // Read other lines. Their cells wait here until we know which
+        // columns are Nums, then move into the rows.
+        std::vector<std::vector<std::string>> table;
         int line_no = 1;
         while (std::getline(fin, line))
         {
@@ -307,11 +626,13 @@ public:
             {
                 std::cerr << "Exception: at line " << line_no << "\n";
                 std::cerr << "Message: Rows with missing or extra values, skipping.\n";
+                INSTRUMENT_COUNT("Tbl::rejected", 1);
                 continue;
             }
 
-            table.push_back(values);
+            table.push_back(std::move(values));
         }
+        INSTRUMENT_COUNT("Tbl::rows", table.size());
 
         // Deal with ? columns
         // Uses the same idea as https://stackoverflow.com/a/12990554
@@ -330,12 +651,15 @@ public:
         skip_indices = q_pos;
 
         // Now use idea from https://stackoverflow.com/a/27265146
-        for (int index : q_pos)
         {
-            std::for_each(table.begin(), table.end(),
-                          [&](std::vector<std::string> &row) {
-                              row.erase(std::next(row.begin(), index));
-                          });
+            INSTRUMENT_SCOPE("Tbl::skip");
+            for (int index : q_pos)
+            {
+                std::for_each(table.begin(), table.end(),
+                              [&](std::vector<std::string> &row) {
+                                  row.erase(std::next(row.begin(), index));
+                              });
+            }
         }
 
         /* Finally, remove those headers from the headers list itself
@@ -347,10 +671,6 @@ public:
         for (int index : q_pos)
             headers.erase(std::next(headers.begin(), index));
 
-        // Build rows
-        for (std::vector<std::string> row : table)
-            rows.push_back(Row(row));
-
         // Create columns
         for (int i = 0; i < headers.size(); i++)
         {
@@ -362,12 +682,12 @@ public:
                 x.find(">") != std::string::npos ||
                 x.find("$") != std::string::npos)
             {
-                cols.emplace_back(new Num(x));
+                add_col(x, true);
                 nums.push_back(i);
             }
             else
             {
-                cols.emplace_back(new Sym<>(x));
+                add_col(x, false);
                 syms.push_back(i);
             }
 
@@ -385,22 +705,28 @@ public:
                 w.push_back(i);
         }
 
-        // Populate values
-        for (int i = 0; i < table.size(); i++)
-        {
-            for (int j = 0; j < table[0].size(); j++)
-                *(cols[j]) += table[i][j];
-        }
+        // Build rows, now that we know which columns are Nums...
+        rows.reserve(rows.size() + table.size());
+        for (std::vector<std::string> &cells : table)
+            rows.push_back(make_row(std::move(cells)));
+        table.clear();
+
+        // ...and populate values
+        for (const Row &row : rows)
+            add_values(row);
     }
 
     void dump()
     {
         std::cout << "t.cols\n";
 
-        for (int i = 0; i < cols.size(); i++)
+        for (int i = 0; i < slots.size(); i++)
         {
             std::cout << "|  " << i + 1 << "\n";
-            cols[i]->print();
+            if (slots[i].first)
+                num_col(i).print();
+            else
+                sym_col(i).print();
         }
 
         std::cout << "t.rows\n";
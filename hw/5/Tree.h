@@ -0,0 +1,427 @@
+#ifndef TREE_H
+#define TREE_H
+
+#include "Columns.h"
+#include "Parallel.h"
+#include "Sort.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <vector>
+
+/**
+ * Decision tree (for a Sym target) or regression tree (for a Num target),
+ * learned from a Columns copy of a table. The target is the last goal.
+ *
+ * Splits follow Divide's rules: impurity is entropy for Syms and standard
+ * deviation for Nums (the same measures as Sym::SymEnt and Num::variety,
+ * kept here as plain counts and sums so the sweeps don't touch maps), a
+ * split must shrink the expected impurity by 2.5%, and both sides need at
+ * least min_leaf rows, which defaults to sqrt(N) like Divide's step. Num
+ * columns split at a threshold, Sym columns on one symbol against the
+ * rest. Every node tries all the xs columns, in parallel when it is big.
+ *
+ * The recursion partitions one array of row numbers in place, and the
+ * tree is stored as a flat array of nodes; prediction just indexes a
+ * node's two children by the test's outcome.
+ */
+class Tree
+{
+    struct Node
+    {
+        int col = -1;         // column tested; -1 in leaves
+        bool numeric = true;  // a threshold test, or a symbol test
+        double value = 0;     // threshold or symbol id; the prediction in leaves
+        bool missing_left = false;
+        int child[2] = {0, 0}; // left, right
+        int n = 0;
+    };
+
+    struct Split
+    {
+        int col = -1;
+        bool numeric = true;
+        double value = 0;
+        double expect = std::numeric_limits<double>::infinity();
+        int left = 0, right = 0; // rows on each side, excluding missing ones
+    };
+
+    std::vector<Node> nodes;
+    int target;
+    bool classes_mode;
+    std::vector<std::string> classes;
+    size_t min_leaf;
+    int max_depth;
+    unsigned threads;
+
+    // Targets of the training rows: class ids or values
+    std::vector<double> y;
+
+    static double entropy(const std::vector<int> &counts, int n)
+    {
+        double e = 0;
+        for (int count : counts)
+        {
+            if (count > 0)
+            {
+                double p = static_cast<double>(count) / n;
+                e -= p * std::log2(p);
+            }
+        }
+        return e;
+    }
+
+    static double sd(double n, double sum, double sumsq)
+    {
+        if (n < 2)
+            return 0;
+        return std::sqrt(std::max(0.0, (sumsq - sum * sum / n) / (n - 1)));
+    }
+
+    double impurity(const uint32_t *rows, size_t n) const
+    {
+        if (classes_mode)
+        {
+            std::vector<int> counts(classes.size(), 0);
+            for (size_t i = 0; i < n; i++)
+                ++counts[static_cast<int>(y[rows[i]])];
+            return entropy(counts, n);
+        }
+
+        double sum = 0, sumsq = 0;
+        for (size_t i = 0; i < n; i++)
+        {
+            sum += y[rows[i]];
+            sumsq += y[rows[i]] * y[rows[i]];
+        }
+        return sd(n, sum, sumsq);
+    }
+
+    Split split_num(const Columns &data, int c, const uint32_t *rows, size_t n) const
+    {
+        Split best;
+        const std::vector<double> &col = data.num(c);
+
+        std::vector<double> xs, ys;
+        for (size_t i = 0; i < n; i++)
+        {
+            double x = col[rows[i]];
+            if (x == x)
+            {
+                xs.push_back(x);
+                ys.push_back(y[rows[i]]);
+            }
+        }
+
+        size_t m = xs.size();
+        if (m < 2 * min_leaf)
+            return best;
+
+        std::vector<uint32_t> order = Sort::argsort(xs);
+
+        std::vector<int> left_counts(classes.size(), 0), right_counts(classes.size(), 0);
+        double ls = 0, lss = 0, rs = 0, rss = 0;
+        for (size_t j = 0; j < m; j++)
+        {
+            if (classes_mode)
+                ++right_counts[static_cast<int>(ys[j])];
+            rs += ys[j];
+            rss += ys[j] * ys[j];
+        }
+
+        for (size_t j = 0; j + 1 < m; j++)
+        {
+            double v = ys[order[j]];
+            if (classes_mode)
+            {
+                ++left_counts[static_cast<int>(v)];
+                --right_counts[static_cast<int>(v)];
+            }
+            ls += v, lss += v * v;
+            rs -= v, rss -= v * v;
+
+            size_t nl = j + 1, nr = m - nl;
+            double now = xs[order[j]], after = xs[order[j + 1]];
+            if (nl < min_leaf || nr < min_leaf || now == after)
+                continue;
+
+            double expect = classes_mode
+                                ? (nl * entropy(left_counts, nl) + nr * entropy(right_counts, nr)) / m
+                                : (nl * sd(nl, ls, lss) + nr * sd(nr, rs, rss)) / m;
+
+            if (expect < best.expect)
+            {
+                best.col = c;
+                best.numeric = true;
+                best.value = (now + after) / 2;
+                best.expect = expect;
+                best.left = nl;
+                best.right = nr;
+            }
+        }
+
+        return best;
+    }
+
+    Split split_sym(const Columns &data, int c, const uint32_t *rows, size_t n) const
+    {
+        Split best;
+        const std::vector<int> &col = data.sym(c);
+        size_t symbols = data.symbol_count(c);
+        size_t k = classes_mode ? classes.size() : 3;
+
+        // Per symbol: class counts, or n / sum / sum of squares
+        std::vector<double> stats(symbols * k, 0), total(k, 0);
+        int m = 0;
+        for (size_t i = 0; i < n; i++)
+        {
+            int s = col[rows[i]];
+            if (s < 0)
+                continue;
+
+            double v = y[rows[i]];
+            double *at = &stats[s * k];
+            if (classes_mode)
+                at[static_cast<int>(v)] += 1;
+            else
+                at[0] += 1, at[1] += v, at[2] += v * v;
+            ++m;
+        }
+
+        for (size_t s = 0; s < symbols; s++)
+            for (size_t j = 0; j < k; j++)
+                total[j] += stats[s * k + j];
+
+        std::vector<int> left_counts(k), right_counts(k);
+        const int least = static_cast<int>(min_leaf);
+        for (size_t s = 0; s < symbols; s++)
+        {
+            const double *at = &stats[s * k];
+            double expect;
+            int nl;
+
+            if (classes_mode)
+            {
+                nl = 0;
+                for (size_t j = 0; j < k; j++)
+                {
+                    left_counts[j] = at[j];
+                    right_counts[j] = total[j] - at[j];
+                    nl += at[j];
+                }
+                int nr = m - nl;
+                if (nl < least || nr < least)
+                    continue;
+                expect = (nl * entropy(left_counts, nl) + nr * entropy(right_counts, nr)) / m;
+            }
+            else
+            {
+                nl = at[0];
+                int nr = m - nl;
+                if (nl < least || nr < least)
+                    continue;
+                expect = (nl * sd(nl, at[1], at[2]) + nr * sd(nr, total[1] - at[1], total[2] - at[2])) / m;
+            }
+
+            if (expect < best.expect)
+            {
+                best.col = c;
+                best.numeric = false;
+                best.value = s;
+                best.expect = expect;
+                best.left = nl;
+                best.right = m - nl;
+            }
+        }
+
+        return best;
+    }
+
+    static bool goes_left(const Node &nd, const Columns &data, size_t row)
+    {
+        if (nd.numeric)
+        {
+            double x = data.num(nd.col)[row];
+            return x != x ? nd.missing_left : x < nd.value;
+        }
+
+        int s = data.sym(nd.col)[row];
+        return s == -1 ? nd.missing_left : s == static_cast<int>(nd.value);
+    }
+
+    double leaf_value(const uint32_t *rows, size_t n) const
+    {
+        if (classes_mode)
+        {
+            std::vector<int> counts(classes.size(), 0);
+            for (size_t i = 0; i < n; i++)
+                ++counts[static_cast<int>(y[rows[i]])];
+            return std::max_element(counts.begin(), counts.end()) - counts.begin();
+        }
+
+        double sum = 0;
+        for (size_t i = 0; i < n; i++)
+            sum += y[rows[i]];
+        return n ? sum / n : 0;
+    }
+
+    int build(const Columns &data, uint32_t *rows, size_t n, int depth)
+    {
+        int me = nodes.size();
+        nodes.push_back(Node());
+        nodes[me].n = n;
+        nodes[me].value = leaf_value(rows, n);
+
+        if (depth >= max_depth || n < 2 * min_leaf)
+            return me;
+
+        double before = impurity(rows, n);
+        if (before == 0)
+            return me;
+
+        // Best split per column, the columns spread over threads when the
+        // node is big enough to pay for them
+        const std::vector<int> &xs = data.get_xs();
+        std::vector<Split> splits(xs.size());
+        parallel_for(xs.size(), n >= 4096 ? threads : 1, [&](size_t begin, size_t end, unsigned) {
+            for (size_t k = begin; k < end; k++)
+            {
+                int c = xs[k];
+                splits[k] = data.is_num(c) ? split_num(data, c, rows, n) : split_sym(data, c, rows, n);
+            }
+        });
+
+        Split best;
+        for (const Split &split : splits)
+            if (split.expect < best.expect)
+                best = split;
+
+        if (best.col < 0 || best.expect * 1.025 >= before)
+            return me;
+
+        Node &nd = nodes[me];
+        nd.col = best.col;
+        nd.numeric = best.numeric;
+        nd.value = best.value;
+        nd.missing_left = best.left >= best.right;
+
+        Node test = nd;
+        uint32_t *mid = std::partition(rows, rows + n,
+                                       [&](uint32_t row) { return goes_left(test, data, row); });
+
+        int left = build(data, rows, mid - rows, depth + 1);
+        int right = build(data, mid, rows + n - mid, depth + 1);
+        nodes[me].child[0] = left;
+        nodes[me].child[1] = right;
+        return me;
+    }
+
+    void print(int node, int depth, const Columns *data) const
+    {
+        const Node &nd = nodes[node];
+        std::string indent;
+        for (int i = 0; i < depth; i++)
+            indent += "|  ";
+
+        if (nd.col < 0)
+        {
+            std::cout << indent << "=> " << (classes_mode ? classes[static_cast<int>(nd.value)] : std::to_string(nd.value))
+                      << " (n: " << nd.n << ")\n";
+            return;
+        }
+
+        std::string test = nd.numeric ? " < " + std::to_string(nd.value)
+                                      : " == " + (data ? data->symbol(nd.col, nd.value) : std::to_string(nd.value));
+        std::cout << indent << "col " << nd.col + 1 << test << "\n";
+        print(nd.child[0], depth + 1, data);
+        std::cout << indent << "col " << nd.col + 1 << " else\n";
+        print(nd.child[1], depth + 1, data);
+    }
+
+public:
+    /**
+     * @param data - The training data
+     * @param min_leaf - Fewest rows on each side of a split; 0 means sqrt(N)
+     * @param max_depth - Deepest a leaf can be
+     * @param threads - Number of threads; 0 means one per core
+     */
+    Tree(const Columns &data, size_t min_leaf = 0, int max_depth = 20, unsigned threads = 0)
+        : min_leaf(min_leaf ? min_leaf : std::max<size_t>(std::sqrt(data.size()), 1)),
+          max_depth(max_depth), threads(threads)
+    {
+        const std::vector<int> &goals = data.get_goals();
+        if (goals.size() == 0)
+            throw "Error: No goals\n";
+
+        target = goals[goals.size() - 1];
+        classes_mode = !data.is_num(target);
+
+        size_t n = data.size();
+        y.resize(n);
+        std::vector<uint32_t> rows;
+        for (size_t i = 0; i < n; i++)
+        {
+            // Rows with no target can't teach anything
+            if (classes_mode ? data.sym(target)[i] < 0 : data.num(target)[i] != data.num(target)[i])
+                continue;
+
+            y[i] = classes_mode ? data.sym(target)[i] : data.num(target)[i];
+            rows.push_back(i);
+        }
+
+        if (classes_mode)
+            for (size_t s = 0; s < data.symbol_count(target); s++)
+                classes.push_back(data.symbol(target, s));
+
+        build(data, rows.data(), rows.size(), 0);
+        y.clear();
+    }
+
+    size_t size() const
+    {
+        return nodes.size();
+    }
+
+    /**
+     * Predicts every row of data, which must be encoded like the training
+     * data. Gives class ids for decision trees and values for regression.
+     *
+     * @param threads - Number of threads; 0 means one per core
+     */
+    std::vector<double> predict(const Columns &data, unsigned threads = 0) const
+    {
+        std::vector<double> out(data.size());
+        parallel_for(data.size(), threads, [&](size_t begin, size_t end, unsigned) {
+            for (size_t i = begin; i < end; i++)
+            {
+                int node = 0;
+                while (nodes[node].col >= 0)
+                    node = nodes[node].child[!goes_left(nodes[node], data, i)];
+                out[i] = nodes[node].value;
+            }
+        });
+        return out;
+    }
+
+    // Like predict(), but gives class names; for decision trees only
+    std::vector<std::string> classify(const Columns &data, unsigned threads = 0) const
+    {
+        std::vector<double> ids = predict(data, threads);
+        std::vector<std::string> out;
+        out.reserve(ids.size());
+        for (double id : ids)
+            out.push_back(classes.empty() ? "" : classes[static_cast<int>(id)]);
+        return out;
+    }
+
+    // Prints the tree; pass the training data to show symbols by name
+    void print(const Columns *data = nullptr) const
+    {
+        print(0, 0, data);
+    }
+};
+
+#endif
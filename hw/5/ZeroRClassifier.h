@@ -3,31 +3,46 @@
 
 #include "Tbl.h"
 #include "Row.h"
+#include "Learner.h"
 
-class ZeroRClassifier
+class ZeroRClassifier : public Learner
 {
     Tbl tbl;
 
 public:
     ZeroRClassifier() = default;
 
-    void add_header(std::string line)
+    void add_header(std::string line) override
     {
         tbl.add_header(line);
     }
 
-    void add_row(std::string line)
+    using Learner::add_row;
+    using Learner::classify;
+
+    bool parse(std::string line, Row &row) const override
+    {
+        return tbl.parse(line, row);
+    }
+
+    void add_row(const Row &row) override
     {
-        tbl.add_row(line);
+        tbl.add_row(row);
     }
 
     std::string classify()
     {
-        auto col = tbl.get_classification_column();
+        const Sym<> &col = tbl.get_classification_column();
         std::string mode = col.get_mode();
 
         return mode;
     }
+
+    // The majority class doesn't depend on the row
+    std::string classify(const Row &) override
+    {
+        return classify();
+    }
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,66 @@
+// Compile with -O2 -I $BOOST_ROOT -std=c++17
+#include "AllocCounter.h"
+#include "Divide.h"
+#include "Num.h"
+#include "Sym.h"
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+ * Reports heap allocations and wall time per Divide run, for numeric and
+ * symbolic targets at a few sizes.
+ */
+template <class ColType, class ValType>
+void run(const char *name, const std::vector<double> &x, const std::vector<ValType> &y)
+{
+    AllocCounter::reset();
+    auto start = std::chrono::steady_clock::now();
+
+    Divide<ColType, ValType> div(x, y);
+
+    auto stop = std::chrono::steady_clock::now();
+    size_t allocs = AllocCounter::allocs;
+    size_t bytes = AllocCounter::bytes;
+    double ms = std::chrono::duration<double, std::milli>(stop - start).count();
+
+    std::printf("%-4s | n %8zu | ranges %4zu | allocs %10zu | allocs/row %7.2f | MB %8.2f | ms %9.2f\n",
+                name, x.size(), div.get_ranges().size(), allocs,
+                static_cast<double>(allocs) / x.size(), bytes / 1e6, ms);
+}
+
+int main(int argc, char **argv)
+{
+    std::mt19937 rng(1);
+    std::normal_distribution<double> noise(0, 0.05);
+    std::vector<std::string> labels = {"a", "b", "c", "d"};
+
+    std::vector<size_t> sizes = {1000, 10000, 100000};
+    if (argc > 1)
+    {
+        sizes.clear();
+        for (int i = 1; i < argc; i++)
+            sizes.push_back(std::stoul(argv[i]));
+    }
+
+    for (size_t n : sizes)
+    {
+        // Four clusters of y values, each tied to a label
+        std::vector<double> x(n), y(n);
+        std::vector<std::string> sy(n);
+        for (size_t i = 0; i < n; i++)
+        {
+            size_t group = rng() % 4;
+            x[i] = group * 0.25 + noise(rng);
+            y[i] = group * 0.25 + noise(rng);
+            sy[i] = labels[group];
+        }
+
+        run<Num, double>("num", x, y);
+        run<Sym<>, std::string>("sym", x, sy);
+    }
+
+    return 0;
+}
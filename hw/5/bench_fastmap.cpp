@@ -0,0 +1,109 @@
+// Compile with -O2 -pthread -I $BOOST_ROOT -std=c++17
+#include "Tbl.h"
+#include "Distance.h"
+#include "FastMap.h"
+#include "Cluster.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+ * Builds a FastMap index over a synthetic table (default 1M rows of
+ * clustered points) and compares its k-nearest-row queries against a
+ * brute-force scan: build time, time per query, and recall. Also times
+ * Cluster over the same table, which is the FastMap tree with sqrt(N)
+ * rows per leaf plus a summary of every leaf.
+ */
+template <class F>
+double time_ms(F f)
+{
+    auto start = std::chrono::steady_clock::now();
+    f();
+    auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(stop - start).count();
+}
+
+int main(int argc, char **argv)
+{
+    size_t n = argc > 1 ? std::stoul(argv[1]) : 1000000;
+    size_t queries = argc > 2 ? std::stoul(argv[2]) : 200;
+    const int dims = 8, clusters = 50, k = 10;
+
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<double> unit(0, 1);
+    std::normal_distribution<double> noise(0, 0.05);
+
+    std::vector<std::vector<double>> centers(clusters, std::vector<double>(dims));
+    for (std::vector<double> &center : centers)
+        for (double &x : center)
+            x = unit(rng);
+
+    Tbl tbl;
+    std::string header;
+    for (int d = 0; d < dims; d++)
+        header += "$x" + std::to_string(d) + ",";
+    tbl.add_header(header + "!class");
+
+    double load = time_ms([&] {
+        for (size_t i = 0; i < n; i++)
+        {
+            int c = rng() % clusters;
+            std::string line;
+            for (int d = 0; d < dims; d++)
+                line += std::to_string(centers[c][d] + noise(rng)) + ",";
+            tbl.add_row(line + "c" + std::to_string(c));
+        }
+    });
+
+    Distance distance(tbl);
+    FastMap *index = nullptr;
+    double build = time_ms([&] { index = new FastMap(distance); });
+
+    // Queries are perturbed copies of random rows
+    std::vector<Distance::Point> points;
+    for (size_t q = 0; q < queries; q++)
+    {
+        Distance::Point p = distance.point(rng() % n);
+        for (double &x : p.nums)
+            x += noise(rng) * 0.1;
+        points.push_back(p);
+    }
+
+    std::vector<std::vector<uint32_t>> exact(queries);
+    double brute = time_ms([&] {
+        std::vector<double> d(n);
+        std::vector<uint32_t> idx(n);
+        for (size_t q = 0; q < queries; q++)
+        {
+            distance.dists(points[q], d.data());
+            std::iota(idx.begin(), idx.end(), 0);
+            std::partial_sort(idx.begin(), idx.begin() + k, idx.end(),
+                              [&](uint32_t a, uint32_t b) { return d[a] < d[b]; });
+            exact[q].assign(idx.begin(), idx.begin() + k);
+        }
+    });
+
+    size_t hits = 0;
+    double approx = time_ms([&] {
+        for (size_t q = 0; q < queries; q++)
+        {
+            for (const std::pair<double, uint32_t> &found : index->nearest(points[q], k))
+                hits += std::count(exact[q].begin(), exact[q].end(), found.second);
+        }
+    });
+
+    size_t leaves = 0;
+    double cluster = time_ms([&] { leaves = Cluster(tbl).get_leaves().size(); });
+
+    std::printf("rows %zu | load %.0f ms | index build %.0f ms (%zu nodes)\n", n, load, build, index->size());
+    std::printf("cluster %.0f ms (%zu leaves)\n", cluster, leaves);
+    std::printf("brute force %.3f ms/query | fastmap %.3f ms/query | speedup %.0fx | recall@%d %.3f\n",
+                brute / queries, approx / queries, brute / approx, k,
+                static_cast<double>(hits) / (queries * k));
+
+    delete index;
+    return 0;
+}
@@ -0,0 +1,106 @@
+// Compile with -O2 -pthread -std=c++17
+#include "ScottKnott.h"
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+ * Ranks synthetic treatments (default 40, each with 100 scores drawn from
+ * one of a few well-separated means) with ScottKnott, on one thread and on
+ * all cores, and times a plain bootstrap with std::mt19937 for reference.
+ */
+template <class F>
+double time_ms(F f)
+{
+    auto start = std::chrono::steady_clock::now();
+    f();
+    auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(stop - start).count();
+}
+
+// The textbook bootstrap: one resample at a time from a sequential generator
+bool plain_different(const std::vector<double> &y0, const std::vector<double> &z0, int b, double conf)
+{
+    auto mean = [](const std::vector<double> &v) {
+        double s = 0;
+        for (double x : v)
+            s += x;
+        return s / v.size();
+    };
+    auto var = [&](const std::vector<double> &v) {
+        double mu = mean(v), s = 0;
+        for (double x : v)
+            s += (x - mu) * (x - mu);
+        return s / (v.size() - 1);
+    };
+    auto delta = [&](const std::vector<double> &y, const std::vector<double> &z) {
+        return std::abs(mean(y) - mean(z)) / std::sqrt(var(y) / y.size() + var(z) / z.size());
+    };
+
+    double observed = delta(y0, z0);
+    double mu = (mean(y0) * y0.size() + mean(z0) * z0.size()) / (y0.size() + z0.size());
+    std::vector<double> yhat(y0), zhat(z0), ys(y0.size()), zs(z0.size());
+    double ym = mean(y0), zm = mean(z0);
+    for (double &x : yhat)
+        x += mu - ym;
+    for (double &x : zhat)
+        x += mu - zm;
+
+    std::mt19937 rng(1);
+    std::uniform_int_distribution<size_t> ypick(0, y0.size() - 1), zpick(0, z0.size() - 1);
+    int bigger = 0;
+    for (int i = 0; i < b; i++)
+    {
+        for (double &x : ys)
+            x = yhat[ypick(rng)];
+        for (double &x : zs)
+            x = zhat[zpick(rng)];
+        bigger += delta(ys, zs) > observed;
+    }
+    return static_cast<double>(bigger) / b < conf;
+}
+
+int main(int argc, char **argv)
+{
+    int count = argc > 1 ? std::stoi(argv[1]) : 40;
+    size_t n = argc > 2 ? std::stoul(argv[2]) : 100;
+
+    std::mt19937 rng(1);
+    std::vector<std::vector<double>> scores(count);
+    for (int t = 0; t < count; t++)
+    {
+        std::normal_distribution<double> score(0.5 + 0.1 * (t % 4), 0.05);
+        for (size_t i = 0; i < n; i++)
+            scores[t].push_back(score(rng));
+    }
+
+    for (unsigned threads : {1u, 0u})
+    {
+        ScottKnott sk(0.05, 1000, 0.147, threads);
+        for (int t = 0; t < count; t++)
+            sk.add("rx" + std::to_string(t), scores[t]);
+
+        int ranks = 0;
+        double ms = time_ms([&] { ranks = sk.rank().back().rank; });
+        std::printf("%s: %d treatments x %zu scores -> %d ranks in %.1f ms\n",
+                    threads ? "1 thread" : "all threads", count, n, ranks, ms);
+
+        if (threads == 0 && count <= 12)
+            sk.report();
+    }
+
+    // One bootstrap over the whole pool split in half, both ways
+    std::vector<double> y, z;
+    for (int t = 0; t < count; t++)
+        (t < count / 2 ? y : z).insert((t < count / 2 ? y : z).end(), scores[t].begin(), scores[t].end());
+
+    ScottKnott sk(0.05, 1000, 0.147, 1);
+    bool fast = false, plain = false;
+    double fast_ms = time_ms([&] { fast = sk.different(y, z); });
+    double plain_ms = time_ms([&] { plain = plain_different(y, z, 1000, 0.05); });
+    std::printf("bootstrap of %zu vs %zu, 1000 resamples: hashed %.1f ms (%d), mt19937 %.1f ms (%d)\n",
+                y.size(), z.size(), fast_ms, fast, plain_ms, plain);
+    return 0;
+}
@@ -0,0 +1,74 @@
+// Compile with -O2 -pthread -std=c++17
+#include "Sort.h"
+#include "Parallel.h"
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * Compares the ways Divide could sort its values: the old std::sort over
+ * (x, y) pairs, a comparison argsort, and the radix argsort on one thread
+ * and on every core. Also times the pre-sorted check on sorted input.
+ */
+template <class F>
+double time_ms(F f)
+{
+    auto start = std::chrono::steady_clock::now();
+    f();
+    auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(stop - start).count();
+}
+
+int main(int argc, char **argv)
+{
+    std::vector<size_t> sizes = {1000000, 10000000, 100000000};
+    if (argc > 1)
+    {
+        sizes.clear();
+        for (int i = 1; i < argc; i++)
+            sizes.push_back(std::stoul(argv[i]));
+    }
+
+    unsigned cores = thread_count();
+    std::mt19937_64 rng(1);
+    std::normal_distribution<double> dist(0, 1);
+
+    for (size_t n : sizes)
+    {
+        std::vector<double> vals(n);
+        for (double &val : vals)
+            val = dist(rng);
+
+        double pairs = time_ms([&] {
+            std::vector<std::pair<double, double>> list(n);
+            for (size_t i = 0; i < n; i++)
+                list[i] = std::make_pair(vals[i], vals[i]);
+            std::sort(list.begin(), list.end(),
+                      [](std::pair<double, double> x, std::pair<double, double> y) { return x.second < y.second; });
+        });
+
+        double compare = time_ms([&] {
+            std::vector<uint32_t> idx(n);
+            std::iota(idx.begin(), idx.end(), 0);
+            std::sort(idx.begin(), idx.end(), [&](uint32_t a, uint32_t b) { return vals[a] < vals[b]; });
+        });
+
+        std::vector<uint32_t> order;
+        double radix = time_ms([&] { order = Sort::argsort(vals, 1); });
+        double parallel = time_ms([&] { order = Sort::argsort(vals, cores); });
+
+        std::vector<double> sorted(n);
+        for (size_t i = 0; i < n; i++)
+            sorted[i] = vals[order[i]];
+        double presorted = time_ms([&] { order = Sort::argsort(sorted, cores); });
+
+        std::printf("n %10zu | pair sort %9.1f ms | argsort %9.1f ms | radix %8.1f ms | radix x%-2u %8.1f ms | "
+                    "pre-sorted %6.1f ms\n",
+                    n, pairs, compare, radix, cores, parallel, presorted);
+    }
+
+    return 0;
+}
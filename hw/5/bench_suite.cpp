@@ -0,0 +1,288 @@
+// Compile with -O2 -pthread -I $BOOST_ROOT -std=c++17
+// (add -DUSE_GOOGLE_BENCHMARK -lbenchmark to use Google Benchmark)
+#include "Benchmark.h"
+#include "Tbl.h"
+#include "Num.h"
+#include "Sym.h"
+#include "NaiveBayes.h"
+#include "Abcd.h"
+#include "Divide.h"
+#include "Generator.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+/**
+ * Microbenchmarks of the hot paths: reading CSVs, updating Nums, Syms and
+ * whole rows, column likelihoods, NaiveBayes classification latency, Abcd
+ * reports and Divide, over synthetic tables from Generator and the
+ * fixtures in ../4. Results are JSON; run from hw/5 so the fixtures are
+ * found, e.g.
+ *
+ *   ./bench_suite --benchmark_out=before.json
+ */
+
+// Path of a synthetic CSV with the given number of rows, written once
+std::string synthetic_csv(size_t rows)
+{
+    std::string path = (std::filesystem::temp_directory_path() / ("bench_suite_" + std::to_string(rows) + ".csv")).string();
+    if (!std::filesystem::exists(path))
+    {
+        Generator::Options opt;
+        opt.rows = rows;
+        opt.missing = 0.01;
+        std::FILE *out = std::fopen(path.c_str(), "w");
+        Generator(opt).write_csv(out, 1);
+        std::fclose(out);
+    }
+    return path;
+}
+
+std::vector<std::string> lines_of(const std::string &path)
+{
+    std::ifstream fin(path);
+    std::vector<std::string> lines;
+    std::string line;
+    while (std::getline(fin, line))
+        if (!line.empty() && line[0] != '#')
+            lines.push_back(line);
+    return lines;
+}
+
+void read_file(benchmark::State &state, const std::string &path)
+{
+    int rows = 0;
+    for (auto _ : state)
+    {
+        Tbl tbl;
+        tbl.read(path);
+        rows = tbl.size();
+    }
+    state.SetItemsProcessed(state.iterations() * rows);
+}
+
+void BM_TblRead(benchmark::State &state)
+{
+    read_file(state, synthetic_csv(state.range(0)));
+}
+BENCHMARK(BM_TblRead)->Arg(1000)->Arg(10000)->Arg(100000);
+
+void BM_TblReadDiabetes(benchmark::State &state)
+{
+    read_file(state, "../4/diabetes.csv");
+}
+BENCHMARK(BM_TblReadDiabetes);
+
+void BM_NumAdd(benchmark::State &state)
+{
+    std::mt19937 rng(1);
+    std::normal_distribution<double> normal(0, 1);
+    std::vector<double> vals(4096);
+    for (double &val : vals)
+        val = normal(rng);
+
+    Num num;
+    size_t i = 0;
+    for (auto _ : state)
+        num.add(vals[i++ & 4095]);
+
+    benchmark::DoNotOptimize(num.get_mean());
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_NumAdd);
+
+// Adds a whole column at once; bytes_per_second is the throughput
+void BM_NumAddBatch(benchmark::State &state)
+{
+    std::mt19937 rng(1);
+    std::normal_distribution<double> normal(0, 1);
+    std::vector<double> vals(state.range(0));
+    for (double &val : vals)
+        val = normal(rng);
+
+    for (auto _ : state)
+    {
+        Num num;
+        num.add(vals.data(), vals.size());
+        benchmark::DoNotOptimize(num.get_var());
+    }
+    state.SetItemsProcessed(state.iterations() * vals.size());
+    state.SetBytesProcessed(state.iterations() * vals.size() * sizeof(double));
+}
+BENCHMARK(BM_NumAddBatch)->Arg(1000)->Arg(100000)->Arg(10000000);
+
+void BM_SymAdd(benchmark::State &state)
+{
+    std::vector<std::string> vals;
+    std::mt19937 rng(1);
+    for (int i = 0; i < 4096; i++)
+        vals.push_back("v" + std::to_string(rng() % state.range(0)));
+
+    Sym<> sym;
+    size_t i = 0;
+    for (auto _ : state)
+        sym.add(vals[i++ & 4095]);
+
+    benchmark::DoNotOptimize(sym.get_mode());
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SymAdd)->Arg(2)->Arg(8)->Arg(64);
+
+// Adds parsed rows to a table, which updates every column summary
+void BM_TblAddRow(benchmark::State &state)
+{
+    std::vector<std::string> lines = lines_of(synthetic_csv(10000));
+    Tbl schema;
+    schema.add_header(lines[0]);
+
+    std::vector<Row> rows(lines.size() - 1);
+    for (size_t i = 1; i < lines.size(); i++)
+        schema.parse(lines[i], rows[i - 1]);
+
+    Tbl tbl;
+    tbl.add_header(lines[0]);
+    size_t i = 0;
+    for (auto _ : state)
+    {
+        tbl.add_row(rows[i]);
+        if (++i == rows.size())
+        {
+            // Start over, so the table doesn't grow without end
+            state.PauseTiming();
+            tbl = Tbl();
+            tbl.add_header(lines[0]);
+            i = 0;
+            state.ResumeTiming();
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_TblAddRow);
+
+// One likelihood per column of a row, as GAUSSIAN NaiveBayes asks for them
+void BM_ColumnLikelihood(benchmark::State &state)
+{
+    Tbl tbl;
+    tbl.read(synthetic_csv(10000));
+    std::vector<int> nums = tbl.get_nums(), syms = tbl.get_syms();
+    const std::vector<Row> &rows = tbl.get_rows();
+
+    double sum = 0;
+    size_t i = 0;
+    for (auto _ : state)
+    {
+        const Row &row = rows[i++ % rows.size()];
+        for (int idx : nums)
+            sum += tbl.get_column_likelihood(idx, row.get_num(idx));
+        for (int idx : syms)
+            sum += tbl.get_column_likelihood(idx, row.get_cells()[idx]);
+    }
+    benchmark::DoNotOptimize(sum);
+    state.SetItemsProcessed(state.iterations() * (nums.size() + syms.size()));
+}
+BENCHMARK(BM_ColumnLikelihood);
+
+/**
+ * Trains on the first 80% of a file and times classify() on each of the
+ * rest, in turn, reporting latency percentiles.
+ */
+void classify_latency(benchmark::State &state, const std::string &path, NaiveBayes::Mode mode)
+{
+    std::vector<std::string> lines = lines_of(path);
+    size_t train = lines.size() * 4 / 5;
+
+    NaiveBayes nb(mode);
+    nb.add_header(lines[0]);
+    for (size_t i = 1; i < train; i++)
+        nb.add_row(lines[i]);
+
+    std::vector<double> ns;
+    ns.reserve(std::min<size_t>(state.iterations(), 10000000));
+    size_t i = train;
+    for (auto _ : state)
+    {
+        auto start = std::chrono::steady_clock::now();
+        std::string pred = nb.classify(lines[i]);
+        auto stop = std::chrono::steady_clock::now();
+
+        benchmark::DoNotOptimize(pred);
+        if (ns.size() < ns.capacity())
+            ns.push_back(std::chrono::duration<double, std::nano>(stop - start).count());
+        if (++i == lines.size())
+            i = train;
+    }
+
+    std::sort(ns.begin(), ns.end());
+    for (double p : {50, 90, 99})
+        state.counters["p" + std::to_string(static_cast<int>(p)) + "_ns"] = ns[std::min(ns.size() - 1, static_cast<size_t>(ns.size() * p / 100))];
+    state.SetItemsProcessed(state.iterations());
+}
+
+void BM_NaiveBayesClassify(benchmark::State &state)
+{
+    classify_latency(state, synthetic_csv(10000), NaiveBayes::GAUSSIAN);
+}
+BENCHMARK(BM_NaiveBayesClassify);
+
+void BM_NaiveBayesClassifyDiscretized(benchmark::State &state)
+{
+    classify_latency(state, synthetic_csv(10000), NaiveBayes::DISCRETIZED);
+}
+BENCHMARK(BM_NaiveBayesClassifyDiscretized);
+
+void BM_NaiveBayesClassifyDiabetes(benchmark::State &state)
+{
+    classify_latency(state, "../4/diabetes.csv", NaiveBayes::GAUSSIAN);
+}
+BENCHMARK(BM_NaiveBayesClassifyDiabetes);
+
+void BM_AbcdReport(benchmark::State &state)
+{
+    std::mt19937 rng(1);
+    const char *classes[] = {"a", "b", "c"};
+    Abcd<std::string> abcd;
+    for (int64_t i = 0; i < state.range(0); i++)
+        abcd.add(classes[rng() % 3], classes[rng() % 3]);
+
+    // report() prints; send stdout to /dev/null while it runs
+    std::fflush(stdout);
+    int saved = dup(fileno(stdout));
+    std::FILE *null = std::fopen("/dev/null", "w");
+    dup2(fileno(null), fileno(stdout));
+
+    for (auto _ : state)
+        abcd.report();
+
+    std::fflush(stdout);
+    dup2(saved, fileno(stdout));
+    close(saved);
+    std::fclose(null);
+
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_AbcdReport)->Arg(100)->Arg(10000)->Arg(1000000);
+
+void BM_Divide(benchmark::State &state)
+{
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<double> unit(0, 1);
+    std::vector<double> x(state.range(0));
+    for (double &val : x)
+        val = unit(rng);
+
+    for (auto _ : state)
+    {
+        Divide<> div(x, x);
+        benchmark::DoNotOptimize(div.get_ranges().size());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_Divide)->Arg(1000)->Arg(10000)->Arg(100000);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,90 @@
+// Compile with -O2 -pthread -I $BOOST_ROOT -std=c++17
+#include "Tbl.h"
+#include "Columns.h"
+#include "Tree.h"
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+ * Trains a decision tree on a synthetic table (default 200k rows) and
+ * predicts a held-out table of the same size in one batch: training time,
+ * prediction throughput, and holdout accuracy. With a CSV file as the
+ * second argument, trains and tests on that file instead.
+ */
+template <class F>
+double time_ms(F f)
+{
+    auto start = std::chrono::steady_clock::now();
+    f();
+    auto stop = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::milli>(stop - start).count();
+}
+
+void fill(Tbl &tbl, size_t n, std::mt19937 &rng)
+{
+    std::uniform_real_distribution<double> unit(0, 1);
+    const char *colors[] = {"red", "green", "blue", "black"};
+
+    tbl.add_header("$a,$b,$c,$d,color,!class");
+    for (size_t i = 0; i < n; i++)
+    {
+        double a = unit(rng), b = unit(rng), c = unit(rng), d = unit(rng);
+        int color = rng() % 4;
+
+        // The class depends on a, b and color; c and d are noise, and 5% of
+        // the labels are flipped
+        bool yes = (a > 0.5 && b < 0.7) || color == 2;
+        if (unit(rng) < 0.05)
+            yes = !yes;
+
+        tbl.add_row(std::to_string(a) + "," + std::to_string(b) + "," + std::to_string(c) + "," +
+                    std::to_string(d) + "," + colors[color] + "," + (yes ? "yes" : "no"));
+    }
+}
+
+int main(int argc, char **argv)
+{
+    size_t n = argc > 1 ? std::stoul(argv[1]) : 200000;
+
+    Tbl train, test;
+    if (argc > 2)
+    {
+        train.read(argv[2]);
+        test.read(argv[2]);
+    }
+    else
+    {
+        std::mt19937 rng(1);
+        fill(train, n, rng);
+        fill(test, n, rng);
+    }
+
+    Columns train_cols(train);
+    Columns test_cols(test, train_cols);
+
+    Tree *tree = nullptr;
+    double fit = time_ms([&] { tree = new Tree(train_cols); });
+
+    std::vector<double> predicted;
+    double predict_one = time_ms([&] { predicted = tree->predict(test_cols, 1); });
+    double predict_all = time_ms([&] { predicted = tree->predict(test_cols); });
+
+    int target = train_cols.get_goals().back();
+    size_t right = 0;
+    for (size_t i = 0; i < test_cols.size(); i++)
+        right += predicted[i] == test_cols.sym(target)[i];
+
+    std::printf("rows %zu | train %.0f ms (%zu nodes)\n", train_cols.size(), fit, tree->size());
+    std::printf("predict 1 thread %.1f M rows/s | all threads %.1f M rows/s | accuracy %.3f\n",
+                test_cols.size() / predict_one / 1000, test_cols.size() / predict_all / 1000,
+                static_cast<double>(right) / test_cols.size());
+
+    if (test_cols.size() < 1000)
+        tree->print(&train_cols);
+
+    delete tree;
+    return 0;
+}
@@ -0,0 +1,485 @@
+// Compile with -O2 -pthread -I $BOOST_ROOT -std=c++17
+#include "CutPoints.h"
+#include "Divide.h"
+#include "Tbl.h"
+#include "Knn.h"
+#include "Cluster.h"
+#include "NaiveBayes.h"
+#include "ZeroRClassifier.h"
+#include "Pipeline.h"
+#include "Generator.h"
+#include "Columns.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <limits>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/**
+ * Checks behaviour that the demo outputs don't cover, on small inputs
+ * and the ../4 data. Prints one line per check and exits with 1 if any
+ * of them failed.
+ */
+int failures = 0;
+
+void check(bool ok, const std::string &what)
+{
+    std::printf("%s %s\n", ok ? "ok  " : "FAIL", what.c_str());
+    failures += !ok;
+}
+
+// The scalar and batch bin() must agree, and keep every value in a bin
+void check_cuts(const std::vector<double> &cuts)
+{
+    const double inf = std::numeric_limits<double>::infinity();
+    std::vector<double> vals = {-inf, inf, cuts.front() - 1, cuts.front(), cuts.back(),
+                                cuts.back() + 1, std::numeric_limits<double>::quiet_NaN()};
+
+    CutPoints cp(cuts);
+    std::vector<int> batch = cp.bin(vals);
+
+    bool agree = true, in_range = true;
+    for (size_t i = 0; i < vals.size(); i++)
+    {
+        agree = agree && batch[i] == cp.bin(vals[i]);
+        in_range = in_range && batch[i] < static_cast<int>(cp.bins()) && (batch[i] >= 0 || vals[i] != vals[i]);
+    }
+
+    std::string name = "CutPoints with " + std::to_string(cuts.size()) + " cuts: ";
+    check(agree, name + "scalar and batch bins agree, at +-inf too");
+    check(in_range, name + "bins stay below bins()");
+    check(cp.bin(inf) == static_cast<int>(cuts.size()) && cp.bin(-inf) == 0, name + "+-inf go to the end bins");
+}
+
+// Divide's trivial must matter: a large enough factor allows no cut
+void check_divide()
+{
+    Tbl tbl;
+    tbl.read("../4/diabetes.csv");
+    std::vector<double> plas;
+    for (const Row &row : tbl.get_rows())
+        plas.push_back(row.get_num(1));
+
+    size_t some = Divide<>(plas, plas, 0.3, 0.5, 1).get_cuts().get_cuts().size();
+    size_t none = Divide<>(plas, plas, 0.3, 0.5, 1e9).get_cuts().get_cuts().size();
+    check(some > 0 && none == 0, "Divide makes " + std::to_string(some) + " cuts of plas with trivial 1, " +
+                                     std::to_string(none) + " with trivial 1e9");
+}
+
+// Asking about a symbol must not change the table
+void check_sym_likelihood()
+{
+    Tbl tbl;
+    tbl.read("../4/weathernon.csv");
+    const Tbl &model = tbl;
+
+    double sunny = model.get_column_likelihood(0, "sunny");
+    double fog = model.get_column_likelihood(0, "fog");
+    bool same = model.get_column_likelihood(0, "fog") == fog && model.get_column_likelihood(0, "sunny") == sunny;
+    check(same && fog < sunny, "Sym likelihoods of seen and unseen symbols don't change the counts");
+}
+
+/**
+ * Reads a CSV file through add_header() and add_row(), as online learners
+ * do, optionally with a different header.
+ */
+Tbl read_lines(const std::string &path, const std::string &header = "")
+{
+    std::ifstream fin(path);
+    std::string line;
+    std::getline(fin, line);
+
+    Tbl tbl;
+    tbl.add_header(header.empty() ? line : header);
+    while (std::getline(fin, line))
+        tbl.add_row(line);
+    return tbl;
+}
+
+// diabetes.csv with mass to minimize and age to maximize, so it has Num goals
+Tbl diabetes_goals()
+{
+    return read_lines("../4/diabetes.csv", "$preg,$plas,$pres,$skin,$insu,<mass,$pedi,>age,!class");
+}
+
+// dom() against Zitzler's indicator computed pair by pair, straight from the cells
+void check_dom()
+{
+    Tbl tbl = diabetes_goals();
+    const std::vector<Row> &rows = tbl.get_rows();
+    size_t n = rows.size();
+
+    std::vector<int> cols = {5, 7};
+    std::vector<double> weights = {-1, 1};
+    std::vector<std::vector<double>> norm(cols.size(), std::vector<double>(n));
+    for (size_t k = 0; k < cols.size(); k++)
+    {
+        double low = INFINITY, high = -INFINITY;
+        for (const Row &row : rows)
+        {
+            low = std::min(low, row.get_num(cols[k]));
+            high = std::max(high, row.get_num(cols[k]));
+        }
+        for (size_t i = 0; i < n; i++)
+            norm[k][i] = (rows[i].get_num(cols[k]) - low) / (high - low);
+    }
+
+    std::vector<int> expected(n, 0);
+    for (size_t x = 0; x < n; x++)
+    {
+        for (size_t y = 0; y < n; y++)
+        {
+            double s1 = 0, s2 = 0;
+            for (size_t k = 0; k < cols.size(); k++)
+            {
+                double a = norm[k][x], b = norm[k][y];
+                s1 -= std::exp(weights[k] * (a - b) / cols.size());
+                s2 -= std::exp(weights[k] * (b - a) / cols.size());
+            }
+            expected[x] += s1 / cols.size() < s2 / cols.size();
+        }
+    }
+
+    tbl.dom(0, 1);
+    size_t same = 0;
+    for (size_t i = 0; i < n; i++)
+        same += tbl.get_rows()[i].get_dom() == expected[i];
+    check(same == n, "Tbl::dom matches the pairwise indicator on " + std::to_string(n) + " rows (" +
+                         std::to_string(same) + " agree)");
+
+    Tbl threaded = diabetes_goals();
+    threaded.dom(0, 3);
+    bool agree = true;
+    for (size_t i = 0; i < n; i++)
+        agree = agree && threaded.get_rows()[i].get_dom() == expected[i];
+    check(agree, "Tbl::dom on 3 threads matches 1 thread");
+
+    Tbl sampled = diabetes_goals();
+    sampled.dom(50, 1);
+    bool bounded = true;
+    for (const Row &row : sampled.get_rows())
+        bounded = bounded && row.get_dom() >= 0 && row.get_dom() <= 50;
+    check(bounded, "Tbl::dom with 50 samples scores every row in [0, 50]");
+
+    tbl.sort_by_dom();
+    bool sorted = true;
+    for (size_t i = 1; i < n; i++)
+        sorted = sorted && tbl.get_rows()[i - 1].get_dom() >= tbl.get_rows()[i].get_dom();
+    check(sorted && tbl.size() == static_cast<int>(n), "Tbl::sort_by_dom keeps every row, best first");
+}
+
+/**
+ * Knn on diabetes.csv, whose features are all Nums, against distances and
+ * votes computed by brute force from the cells.
+ */
+void check_knn()
+{
+    Tbl tbl;
+    tbl.read("../4/diabetes.csv");
+    const std::vector<Row> &rows = tbl.get_rows();
+    size_t n = rows.size();
+    std::vector<int> xs = tbl.get_xs();
+    int target = tbl.get_goals().back();
+
+    std::vector<double> lows(xs.size(), INFINITY), highs(xs.size(), -INFINITY);
+    for (const Row &row : rows)
+    {
+        for (size_t k = 0; k < xs.size(); k++)
+        {
+            lows[k] = std::min(lows[k], row.get_num(xs[k]));
+            highs[k] = std::max(highs[k], row.get_num(xs[k]));
+        }
+    }
+
+    auto reference = [&](size_t i, size_t j) {
+        double sum = 0;
+        for (size_t k = 0; k < xs.size(); k++)
+        {
+            double d = (rows[i].get_num(xs[k]) - rows[j].get_num(xs[k])) / (highs[k] - lows[k]);
+            sum += d * d;
+        }
+        return std::sqrt(sum / xs.size());
+    };
+
+    Distance distance(tbl);
+    double worst = 0;
+    bool symmetric = true;
+    for (size_t i = 0; i < n; i += 7)
+    {
+        for (size_t j = 0; j < n; j += 5)
+        {
+            worst = std::max(worst, std::abs(distance.dist(i, j) - reference(i, j)));
+            symmetric = symmetric && distance.dist(i, j) == distance.dist(j, i);
+        }
+    }
+    check(worst < 1e-12, "Distance matches normalized Euclidean distance from the cells");
+    check(symmetric && distance.dist(3, 3) == 0, "Distance is symmetric and zero from a row to itself");
+
+    // Leave-one-out, 5 nearest; ties in the vote go to the nearer neighbour
+    Knn knn(tbl, 5);
+    size_t same = 0, right = 0, majority = 0;
+    std::map<std::string, size_t> counts;
+    for (size_t i = 0; i < n; i++)
+    {
+        std::vector<std::pair<double, size_t>> near;
+        for (size_t j = 0; j < n; j++)
+            if (j != i)
+                near.emplace_back(reference(i, j), j);
+        std::partial_sort(near.begin(), near.begin() + 5, near.end());
+
+        std::map<std::string, int> votes;
+        std::string best = rows[near[0].second].get_cells()[target];
+        for (size_t m = 0; m < 5; m++)
+        {
+            const std::string &label = rows[near[m].second].get_cells()[target];
+            if (++votes[label] > votes[best])
+                best = label;
+        }
+
+        std::string predicted = knn.classify(i);
+        same += predicted == best;
+        right += predicted == rows[i].get_cells()[target];
+        majority = std::max(majority, ++counts[rows[i].get_cells()[target]]);
+    }
+    check(same == n, "Knn leave-one-out votes match brute force (" + std::to_string(same) + " of " +
+                         std::to_string(n) + ")");
+    check(right > majority, "Knn leave-one-out accuracy " + std::to_string(right * 100 / n) +
+                                "% beats the majority class, " + std::to_string(majority * 100 / n) + "%");
+
+    std::vector<Row> queries;
+    for (size_t i = 0; i < n; i += 3)
+        queries.push_back(rows[i]);
+    std::vector<std::string> batch = knn.classify(queries, 3);
+    bool agree = true;
+    for (size_t q = 0; q < queries.size(); q++)
+        agree = agree && batch[q] == knn.classify(queries[q]);
+    check(agree, "Knn batch classify on 3 threads matches one row at a time");
+}
+
+// Cluster's leaves must split the rows between them, and summarize them
+void check_cluster()
+{
+    Tbl tbl;
+    tbl.read("../4/diabetes.csv");
+    const std::vector<Row> &rows = tbl.get_rows();
+    size_t n = rows.size();
+    std::vector<int> nums = tbl.get_nums(), syms = tbl.get_syms();
+    size_t most = std::sqrt(n);
+
+    Cluster cluster(tbl, 1), threaded(tbl, 3);
+    const std::vector<TblView> &leaves = cluster.get_leaves();
+
+    std::vector<int> seen(n, 0);
+    bool small = true, summarized = true;
+    for (const TblView &leaf : leaves)
+    {
+        small = small && leaf.size() > 0 && leaf.size() <= most;
+        for (uint32_t r : leaf)
+            seen[r]++;
+
+        for (size_t k = 0; k < nums.size(); k++)
+        {
+            double sum = 0;
+            for (uint32_t r : leaf)
+                sum += rows[r].get_num(nums[k]);
+            const Num &num = leaf.get_nums()[k];
+            summarized = summarized && num.size() == static_cast<int>(leaf.size()) &&
+                         std::abs(num.get_mean() - sum / leaf.size()) < 1e-9;
+        }
+        for (size_t k = 0; k < syms.size(); k++)
+            summarized = summarized && leaf.get_syms()[k].size() == static_cast<int>(leaf.size());
+    }
+
+    check(std::count(seen.begin(), seen.end(), 1) == static_cast<long>(n),
+          "Cluster's " + std::to_string(leaves.size()) + " leaves hold every row once");
+    check(small, "Cluster's leaves hold 1 to sqrt(N) = " + std::to_string(most) + " rows");
+    check(summarized, "Cluster's leaf summaries match their rows");
+
+    bool agree = threaded.get_leaves().size() == leaves.size();
+    for (size_t l = 0; agree && l < leaves.size(); l++)
+        agree = std::equal(leaves[l].begin(), leaves[l].end(), threaded.get_leaves()[l].begin(),
+                           threaded.get_leaves()[l].end());
+    check(agree, "Cluster on 3 threads makes the same leaves as 1 thread");
+}
+
+// diabetes.csv with plas ignored, which shifts every column after it
+const std::string SKIP_HEADER = "$preg,?$plas,$pres,$skin,$insu,$mass,$pedi,$age,!class";
+
+/**
+ * A table with an ignored (?) column must look the same whether it is
+ * read() or built from add_header() and add_row(), and learners must
+ * train on it in both modes.
+ */
+void check_skipped_column()
+{
+    std::ifstream fin("../4/diabetes.csv");
+    std::ofstream fout("/tmp/check_skip.csv");
+    std::string line;
+    std::getline(fin, line);
+    fout << SKIP_HEADER << "\n";
+    while (std::getline(fin, line))
+        fout << line << "\n";
+    fout.close();
+
+    Tbl read, added = read_lines("/tmp/check_skip.csv");
+    read.read("/tmp/check_skip.csv");
+
+    bool same = read.size() == added.size() && read.get_headers() == added.get_headers() &&
+                read.get_nums() == added.get_nums() && read.get_syms() == added.get_syms() &&
+                read.get_goals() == added.get_goals();
+    for (int i = 0; same && i < read.size(); i++)
+        same = read.get_rows()[i].get_cells() == added.get_rows()[i].get_cells();
+    check(same && added.size() == 768 && added.get_headers().size() == 8,
+          "A ? column: read() and add_row() keep the same 768 rows of 8 columns");
+
+    const char *names[] = {"GAUSSIAN", "DISCRETIZED"};
+    NaiveBayes::Mode modes[] = {NaiveBayes::GAUSSIAN, NaiveBayes::DISCRETIZED};
+    for (int m = 0; m < 2; m++)
+    {
+        NaiveBayes nb(modes[m]);
+        nb.add_header(SKIP_HEADER);
+        for (const Row &row : added.get_rows())
+            nb.add_row(row);
+
+        size_t right = 0;
+        for (const Row &row : added.get_rows())
+            right += nb.classify(row) == row.get_cells().back();
+        check(nb.classes() == 2 && right > 0.65 * added.size(),
+              std::string("A ? column: ") + names[m] + " NaiveBayes learns " + std::to_string(nb.classes()) +
+                  " classes, " + std::to_string(right * 100 / added.size()) + "% right on its training rows");
+    }
+}
+
+// A short line must be dropped before it reaches any learner
+void check_short_rows()
+{
+    std::ifstream fin("../4/diabetes.csv");
+    std::stringstream in;
+    in << fin.rdbuf() << "\n6,148\n";
+
+    Pipeline pipeline;
+    pipeline.add("zeror", std::unique_ptr<Learner>(new ZeroRClassifier()));
+    pipeline.add("nb", std::unique_ptr<Learner>(new NaiveBayes()));
+    pipeline.add("nb-bins", std::unique_ptr<Learner>(new NaiveBayes(NaiveBayes::DISCRETIZED)));
+
+    bool all = true;
+    for (const Pipeline::Result &result : pipeline.run(in))
+        all = all && result.rows == 768;
+    check(all && pipeline.get_rejected() == 1, "Pipeline drops a short line and runs every learner on the 768 others");
+
+    NaiveBayes nb(NaiveBayes::DISCRETIZED);
+    nb.add_header(SKIP_HEADER);
+    nb.add_row("6,148");
+    nb.add_row("6,148,72,35,0,33.6,0.627,50,tested_positive");
+    check(nb.classes() == 1, "DISCRETIZED NaiveBayes skips a short line");
+}
+
+// A missing Num cell must leave the other cells to decide the class
+void check_missing_cells()
+{
+    std::ifstream fin("../4/diabetes.csv");
+    std::string header, line;
+    std::getline(fin, header);
+
+    Tbl tbl;
+    tbl.add_header(header);
+    NaiveBayes nb;
+    nb.add_header(header);
+
+    std::vector<std::string> lines;
+    while (std::getline(fin, line))
+    {
+        nb.add_row(line);
+        lines.push_back(line);
+    }
+
+    // Blank plas, the second cell, and compare with the full row
+    size_t confident = 0, agree = 0;
+    NaiveBayes::Scores full, blank;
+    for (const std::string &l : lines)
+    {
+        size_t from = l.find(',') + 1, to = l.find(',', from);
+        Row row, missing;
+        tbl.parse(l, row);
+        tbl.parse(l.substr(0, from) + "?" + l.substr(to), missing);
+
+        nb.predict(row, full, 1);
+        nb.predict(missing, blank, 1);
+        confident += blank.top[0].probability > 0.5 + 1e-9;
+        agree += *blank.top[0].label == *full.top[0].label;
+    }
+    check(confident == lines.size() && agree > 0.75 * lines.size(),
+          "GAUSSIAN NaiveBayes skips a missing Num cell: " + std::to_string(agree * 100 / lines.size()) +
+              "% of predictions match the full rows, none uniform");
+}
+
+// A symbol first seen in one class adds a level to every class's smoothing
+void check_discrete_levels()
+{
+    NaiveBayes nb(NaiveBayes::DISCRETIZED);
+    nb.add_header("outlook,!play");
+    nb.add_row("sunny,yes");
+    nb.add_row("rain,no");
+    nb.add_row("overcast,no");
+
+    // yes: 1/3 * (1 + 1) / (1 + 3); no: 2/3 * (0 + 1) / (2 + 3)
+    Row row;
+    NaiveBayes::Scores scores;
+    nb.parse("sunny,?", row);
+    nb.predict(row, scores);
+    check(scores.top.size() == 2 && *scores.top[0].label == "yes" &&
+              std::abs(scores.top[0].probability - 5.0 / 9) < 1e-9,
+          "DISCRETIZED NaiveBayes smooths every class over all 3 symbols: P(yes) = " +
+              std::to_string(scores.top.empty() ? 0 : scores.top[0].probability));
+}
+
+// A truncated binary table keeps its whole groups and nothing zero-filled
+void check_truncated_columns()
+{
+    Generator::Options opt;
+    opt.rows = 40000;
+    std::FILE *out = std::fopen("/tmp/check_cols.bin", "wb");
+    Generator(opt).write_binary(out, 1);
+    std::fclose(out);
+
+    std::ifstream fin("/tmp/check_cols.bin", std::ios::binary);
+    std::string bytes((std::istreambuf_iterator<char>(fin)), std::istreambuf_iterator<char>());
+    std::ofstream("/tmp/check_cols.bin", std::ios::binary).write(bytes.data(), bytes.size() - 100);
+
+    std::FILE *in = std::fopen("/tmp/check_cols.bin", "rb");
+    Columns cols(in);
+    std::fclose(in);
+
+    bool same = true;
+    for (size_t c = 0; c < cols.width(); c++)
+        same = same && (cols.is_num(c) ? cols.num(c).size() : cols.sym(c).size()) == cols.size();
+    check(cols.size() > 0 && cols.size() < opt.rows && cols.size() % 16384 == 0 && same,
+          "Columns keeps the " + std::to_string(cols.size()) + " whole rows of a truncated binary table");
+}
+
+int main()
+{
+    check_cuts({1, 2});
+
+    std::vector<double> many;
+    for (int i = 0; i < 20; i++)
+        many.push_back(i);
+    check_cuts(many);
+
+    check_divide();
+    check_sym_likelihood();
+    check_dom();
+    check_knn();
+    check_cluster();
+    check_skipped_column();
+    check_short_rows();
+    check_truncated_columns();
+    check_discrete_levels();
+    check_missing_cells();
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,51 @@
+// Compile with -O2 -pthread -I $BOOST_ROOT -std=c++17
+#include "Tbl.h"
+#include "ZeroRClassifier.h"
+#include "NaiveBayes.h"
+#include "CrossVal.h"
+#include "ScottKnott.h"
+#include <cstdio>
+#include <memory>
+#include <string>
+#include <vector>
+
+/**
+ * 5×5 cross-validation of ZeroR and both kinds of NaiveBayes on a CSV file
+ * (default ../4/diabetes.csv): time per fold, the merged Abcd report of
+ * each learner, and a Scott-Knott ranking of their per-fold accuracies.
+ */
+int main(int argc, char **argv)
+{
+    Tbl tbl;
+    tbl.read(argc > 1 ? argv[1] : "../4/diabetes.csv");
+
+    std::vector<std::pair<std::string, CrossVal::Factory>> learners = {
+        {"zeror", [] { return std::unique_ptr<Learner>(new ZeroRClassifier()); }},
+        {"nb", [] { return std::unique_ptr<Learner>(new NaiveBayes()); }},
+        {"nb-bins", [] { return std::unique_ptr<Learner>(new NaiveBayes(NaiveBayes::DISCRETIZED)); }},
+    };
+
+    CrossVal cv(tbl);
+    ScottKnott sk;
+
+    for (const auto &learner : learners)
+    {
+        std::vector<CrossVal::Fold> folds = cv.run(learner.second);
+
+        std::vector<double> accs;
+        std::printf("%s ms per fold:", learner.first.c_str());
+        for (const CrossVal::Fold &fold : folds)
+        {
+            std::printf(" %.1f", fold.ms);
+            accs.push_back(fold.abcd.accuracy());
+        }
+        std::printf("\n");
+
+        CrossVal::merge(folds).report("data", learner.first);
+        std::printf("\n");
+        sk.add(learner.first, accs);
+    }
+
+    sk.report();
+    return 0;
+}
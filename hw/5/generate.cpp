@@ -0,0 +1,89 @@
+// Compile with -O2 -pthread -std=c++17
+#include "Generator.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+/**
+ * Writes a synthetic table. Usage:
+ *
+ *   generate [options] > out.csv
+ *
+ *   --rows N, --nums N, --syms N, --cardinality N, --classes N,
+ *   --balance F, --missing F, --skips N, --goals N, --comments F,
+ *   --seed N, --threads N, --binary (write the columnar format instead)
+ *
+ * Prints the time taken and the throughput to stderr.
+ */
+int main(int argc, char **argv)
+{
+    Generator::Options opt;
+    unsigned threads = 0;
+    bool binary = false;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string flag = argv[i];
+        if (flag == "--binary")
+        {
+            binary = true;
+            continue;
+        }
+        if (i + 1 >= argc)
+        {
+            std::fprintf(stderr, "Error: %s needs a value\n", argv[i]);
+            return 1;
+        }
+
+        const char *val = argv[++i];
+        if (flag == "--rows")
+            opt.rows = std::stoull(val);
+        else if (flag == "--nums")
+            opt.nums = std::stoi(val);
+        else if (flag == "--syms")
+            opt.syms = std::stoi(val);
+        else if (flag == "--cardinality")
+            opt.cardinality = std::stoi(val);
+        else if (flag == "--classes")
+            opt.classes = std::stoi(val);
+        else if (flag == "--balance")
+            opt.balance = std::stod(val);
+        else if (flag == "--missing")
+            opt.missing = std::stod(val);
+        else if (flag == "--skips")
+            opt.skips = std::stoi(val);
+        else if (flag == "--goals")
+            opt.goals = std::stoi(val);
+        else if (flag == "--comments")
+            opt.comments = std::stod(val);
+        else if (flag == "--seed")
+            opt.seed = std::stoull(val);
+        else if (flag == "--threads")
+            threads = std::stoul(val);
+        else
+        {
+            std::fprintf(stderr, "Error: unknown option %s\n", flag.c_str());
+            return 1;
+        }
+    }
+
+    Generator gen(opt);
+    auto start = std::chrono::steady_clock::now();
+
+    size_t bytes = 0;
+    if (binary)
+        gen.write_binary(stdout, threads);
+    else
+        bytes = gen.write_csv(stdout, threads);
+    std::fflush(stdout);
+
+    auto stop = std::chrono::steady_clock::now();
+    double seconds = std::chrono::duration<double>(stop - start).count();
+    std::fprintf(stderr, "%zu rows in %.2f s", opt.rows, seconds);
+    if (bytes)
+        std::fprintf(stderr, ", %.0f MB/s", bytes / seconds / 1e6);
+    std::fprintf(stderr, "\n");
+
+    return 0;
+}
@@ -0,0 +1,69 @@
+// Compile with -O2 -pthread -I $BOOST_ROOT -std=c++17
+#include "AllocCounter.h"
+#include "NaiveBayes.h"
+#include "Abcd.h"
+#include <cstdio>
+#include <map>
+#include <string>
+
+/**
+ * Memory used by each step of reading a CSV file (default
+ * ../4/diabetes.csv) and training and testing both kinds of NaiveBayes on
+ * it: the estimated footprint of every structure, and the allocations
+ * the counting allocator charged to each stage.
+ */
+void print(const char *name, size_t total, const std::map<std::string, size_t> &parts)
+{
+    std::printf("%-24s %10.3f MB\n", name, total / 1e6);
+    for (const std::pair<const std::string, size_t> &part : parts)
+        std::printf("  %-22s %10.3f MB\n", part.first.c_str(), part.second / 1e6);
+}
+
+int main(int argc, char **argv)
+{
+    std::string path = argc > 1 ? argv[1] : "../4/diabetes.csv";
+
+    Tbl tbl;
+    {
+        AllocCounter::Stage stage("read");
+        tbl.read(path);
+    }
+    print("Tbl", tbl.memory_usage(), tbl.memory_breakdown());
+
+    std::string header;
+    for (const std::string &name : tbl.get_headers())
+        header += (header.empty() ? "" : ",") + name;
+    std::vector<int> goals = tbl.get_goals();
+    if (goals.empty())
+    {
+        std::cerr << "Error: No goals\n";
+        return 1;
+    }
+    int target = goals[goals.size() - 1];
+
+    NaiveBayes::Mode modes[] = {NaiveBayes::GAUSSIAN, NaiveBayes::DISCRETIZED};
+    const char *names[] = {"nb", "nb-bins"};
+    for (int m = 0; m < 2; m++)
+    {
+        NaiveBayes nb(modes[m]);
+        Abcd<std::string> abcd;
+        {
+            AllocCounter::Stage stage(m ? "train nb-bins" : "train nb");
+            nb.add_header(header);
+            for (const Row &row : tbl.get_rows())
+                nb.add_row(row);
+        }
+        {
+            AllocCounter::Stage stage(m ? "test nb-bins" : "test nb");
+            for (const Row &row : tbl.get_rows())
+                abcd.add(row.get_cells()[target], nb.classify(row));
+        }
+
+        print(names[m], nb.memory_usage(), nb.memory_breakdown());
+        std::printf("%-24s %10.3f MB\n", "Abcd", abcd.memory_usage() / 1e6);
+    }
+
+    std::printf("\n");
+    AllocCounter::report();
+    return 0;
+}
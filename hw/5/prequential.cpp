@@ -0,0 +1,52 @@
+// Compile with -O2 -pthread -I $BOOST_ROOT -std=c++17
+#include "ZeroRClassifier.h"
+#include "NaiveBayes.h"
+#include "Pipeline.h"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+/**
+ * One prequential pass of ZeroR and both kinds of NaiveBayes over a CSV
+ * file (default ../4/diabetes.csv), optionally with its rows repeated
+ * some number of times: rows per second and the Abcd report of each.
+ */
+int main(int argc, char **argv)
+{
+    std::ifstream fin(argc > 1 ? argv[1] : "../4/diabetes.csv");
+    int repeats = argc > 2 ? std::stoi(argv[2]) : 1;
+
+    std::string header, line, body;
+    std::getline(fin, header);
+    while (std::getline(fin, line))
+        body += line + "\n";
+
+    std::stringstream in;
+    in << header << "\n";
+    for (int i = 0; i < repeats; i++)
+        in << body;
+
+    Pipeline pipeline;
+    pipeline.add("zeror", std::unique_ptr<Learner>(new ZeroRClassifier()));
+    pipeline.add("nb", std::unique_ptr<Learner>(new NaiveBayes()));
+    pipeline.add("nb-bins", std::unique_ptr<Learner>(new NaiveBayes(NaiveBayes::DISCRETIZED)));
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<Pipeline::Result> results = pipeline.run(in);
+    auto stop = std::chrono::steady_clock::now();
+    double wall = std::chrono::duration<double>(stop - start).count();
+
+    for (Pipeline::Result &result : results)
+    {
+        std::printf("%s: %zu rows, %.0f rows/s\n", result.name.c_str(), result.rows,
+                    result.rows / result.seconds);
+        result.abcd.report("data", result.name);
+        std::printf("\n");
+    }
+    std::printf("rejected %zu lines with missing or extra values\n", pipeline.get_rejected());
+    std::printf("wall time %.3f s\n", wall);
+
+    return 0;
+}
@@ -0,0 +1,54 @@
+// Compile with -O2 -pthread -I $BOOST_ROOT -std=c++17
+#include "Tbl.h"
+#include "NaiveBayes.h"
+#include "CrossVal.h"
+#include "DE.h"
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <vector>
+
+/**
+ * Tunes discretized NaiveBayes on a CSV file (default ../4/diabetes.csv)
+ * with differential evolution: smoothing, warm-up, and Divide's three
+ * magic numbers, scored by the accuracy of a 3×3 cross-validation.
+ */
+int main(int argc, char **argv)
+{
+    Tbl tbl;
+    tbl.read(argc > 1 ? argv[1] : "../4/diabetes.csv");
+    int generations = argc > 2 ? std::stoi(argv[2]) : 10;
+
+    std::vector<DE::Setting> settings = {
+        {"k", 0.05, 3},
+        {"warmup", 5, 200, true},
+        {"cohen", 0.05, 1},
+        {"size", 0.2, 0.8},
+        {"trivial", 1, 1.2},
+    };
+    std::vector<double> defaults = {1, 20, 0.3, 0.5, 1.025};
+
+    // Candidates already run in parallel, so each cross-validation gets
+    // one thread
+    CrossVal cv(tbl, 3, 3, 1);
+    DE::Objective objective = [&](const std::vector<double> &x) {
+        std::vector<CrossVal::Fold> folds = cv.run([&] {
+            return std::unique_ptr<Learner>(new NaiveBayes(NaiveBayes::DISCRETIZED, x[0], x[1], x[2], x[3], x[4]));
+        });
+        return CrossVal::merge(folds).accuracy();
+    };
+
+    DE de(settings, 0, generations);
+    auto start = std::chrono::steady_clock::now();
+    std::vector<double> best = de.run(objective, defaults);
+    auto stop = std::chrono::steady_clock::now();
+
+    std::printf("%d generations in %.2f s: %zu cross-validations, %zu remembered\n", generations,
+                std::chrono::duration<double>(stop - start).count(), de.get_evaluations(), de.get_hits());
+    std::printf("%10s | %8s | %8s\n", "setting", "default", "tuned");
+    for (size_t i = 0; i < settings.size(); i++)
+        std::printf("%10s | %8.3f | %8.3f\n", settings[i].name.c_str(), defaults[i], best[i]);
+    std::printf("%10s | %8.3f | %8.3f\n", "accuracy", de.get_score(defaults), de.get_score(best));
+
+    return 0;
+}